@@ -1,31 +1,29 @@
 #version 430
 
+// sample count of the main target, defined by the application
+#ifndef NUM_SAMPLES
+#define NUM_SAMPLES 4
+#endif
+
 layout(binding = 0) uniform sampler2DMS u_texture;
-uniform float u_exposure = 1;
+uniform bool u_gammaCorrect = true; // off when the display target is srgb, the hardware encodes on write
 
 in vec2 v_texCoord;
 out vec4 o_color;
 
-vec4 texture(sampler2DMS tex, vec2 texCoord, int numSamples)
-{
-    vec4 color = vec4(0);
-    ivec2 size = textureSize(tex);
-
-    for(int i = 0; i < numSamples; ++i)
-    {
-        color += texelFetch(tex, ivec2(vec2(size) * texCoord), i);
-    }
-
-    color /= numSamples;
-
-    return color;
-}
+#include "../include/tonemap.glsl"
 
 void main() 
 {
-    vec3 hdrColor = texture(u_texture, v_texCoord, 4).rgb;
-    vec3 mappedColor = 1 - exp(-hdrColor * u_exposure);
+    // tonemapping every sample before averaging keeps bright edges antialiased, unlike a plain resolve.
+    // the render targets are over-allocated, both passes draw into the same viewport from the origin
+    vec3 mappedColor = vec3(0);
+    for(int i = 0; i < NUM_SAMPLES; ++i)
+    {
+        mappedColor += tonemap(texelFetch(u_texture, ivec2(gl_FragCoord.xy), i).rgb);
+    }
+    mappedColor /= NUM_SAMPLES;
     
     o_color = vec4(mappedColor, 1);
-    o_color.rgb = pow(o_color.rgb, vec3(1/2.2)); // apply gamma correction
-}
\ No newline at end of file
+    if(u_gammaCorrect) o_color.rgb = pow(o_color.rgb, vec3(1/2.2)); // apply gamma correction
+}
@@ -0,0 +1,10 @@
+// per frame camera, filled once by the application. std140, same layout as CameraUniforms in main.cpp
+layout(std140, binding = 0) uniform Camera {
+    mat4 u_viewMat;
+    mat4 u_projectionMat;
+    mat4 u_viewProjMat;
+    vec4 u_cameraPos;       // world space, w unused
+    vec2 u_viewportSize;    // pixels
+    float u_time;           // seconds since start
+    float u_deltatime;
+};
@@ -0,0 +1,7 @@
+// exposure and the tonemap curve, the same in every post path
+uniform float u_exposure = 1;
+
+vec3 tonemap(vec3 hdrColor)
+{
+    return 1 - exp(-hdrColor * u_exposure);
+}
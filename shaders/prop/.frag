@@ -7,7 +7,10 @@ in VS_OUT {
     vec3 normal;
 } fs_in;
 
+layout(binding = 1) uniform samplerCube u_flow;
+
 void main() 
 {
-    o_color = vec4(fs_in.fragPos, 1);
+    vec2 flow = texture(u_flow, fs_in.fragPos).rg;
+    o_color = vec4(flow * 0.5 + 0.5, 0, 1);
 }
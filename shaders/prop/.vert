@@ -1,21 +1,25 @@
-#version 330 core
+#version 430 core
 layout(location = 0) in vec4 a_position;
 layout(location = 1) in vec4 a_normal;
 layout(location = 2) in vec2 a_texCoord;
 
+// quantized positions are in [0, 1] within the mesh bounds, scale 1 and offset 0 for float positions
+uniform vec3 u_positionScale;
+uniform vec3 u_positionOffset;
+
 out VS_OUT {
     vec2 texCoords;
     vec3 fragPos;
     vec3 normal;
 } vs_out;
 
-uniform mat4 u_projectionMat;
-uniform mat4 u_viewMat;
+#include "../include/camera.glsl"
 
 void main() {
-    gl_Position = u_projectionMat * u_viewMat * a_position;
+    vec3 position = a_position.xyz * u_positionScale + u_positionOffset;
+    gl_Position = u_viewProjMat * vec4(position, 1);
     vs_out.texCoords = a_texCoord;
-    vs_out.fragPos = vec3(a_position);
+    vs_out.fragPos = position;
     
     vs_out.normal = normalize(vec3(a_normal));
 }
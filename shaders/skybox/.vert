@@ -19,8 +19,7 @@ const vec3 cubePositions[14] = {
 
 out vec3 v_texCoords;
 
-uniform mat4 u_projectionMat;
-uniform mat4 u_viewMat;
+#include "../include/camera.glsl"
 
 void main() {
     vec3 position = cubePositions[gl_VertexID];
@@ -0,0 +1,64 @@
+#version 430
+
+// single sampled input, resolved by a framebuffer blit or rendered without msaa
+layout(binding = 0) uniform sampler2D u_texture;
+uniform bool u_gammaCorrect = true; // off when the display target is srgb, the hardware encodes on write
+uniform ivec2 u_viewport; // the input is over-allocated, only this much of it from the origin is valid
+
+in vec2 v_texCoord;
+out vec4 o_color;
+
+#include "../include/tonemap.glsl"
+
+#ifdef FXAA
+// fxaa by Timothy Lottes, the compact pc variant. runs on tonemapped colors, bilinear taps are tonemapped after filtering
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_SPAN_MAX 8.0
+
+vec3 sampleMapped(vec2 uv, vec2 uvMax)
+{
+    return tonemap(textureLod(u_texture, min(uv, uvMax), 0).rgb);
+}
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+vec3 fxaa(vec2 fragCoord)
+{
+    vec2 texel = 1.0 / vec2(textureSize(u_texture, 0));
+    vec2 uvMax = (vec2(u_viewport) - 0.5) * texel;
+    vec2 uv = fragCoord * texel;
+
+    vec3 colorM = tonemap(texelFetch(u_texture, ivec2(fragCoord), 0).rgb);
+    float lumaNW = luma(sampleMapped(uv + vec2(-1, -1) * texel, uvMax));
+    float lumaNE = luma(sampleMapped(uv + vec2( 1, -1) * texel, uvMax));
+    float lumaSW = luma(sampleMapped(uv + vec2(-1,  1) * texel, uvMax));
+    float lumaSE = luma(sampleMapped(uv + vec2( 1,  1) * texel, uvMax));
+    float lumaM = luma(colorM);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texel;
+
+    vec3 colorA = 0.5 * (sampleMapped(uv + dir * (1.0 / 3.0 - 0.5), uvMax) + sampleMapped(uv + dir * (2.0 / 3.0 - 0.5), uvMax));
+    vec3 colorB = colorA * 0.5 + 0.25 * (sampleMapped(uv - dir * 0.5, uvMax) + sampleMapped(uv + dir * 0.5, uvMax));
+    float lumaB = luma(colorB);
+    return lumaB < lumaMin || lumaB > lumaMax ? colorA : colorB;
+}
+#endif
+
+void main() 
+{
+#ifdef FXAA
+    vec3 mappedColor = fxaa(gl_FragCoord.xy);
+#else
+    vec3 mappedColor = tonemap(texelFetch(u_texture, ivec2(gl_FragCoord.xy), 0).rgb);
+#endif
+    
+    o_color = vec4(mappedColor, 1);
+    if(u_gammaCorrect) o_color.rgb = pow(o_color.rgb, vec3(1/2.2)); // apply gamma correction
+}
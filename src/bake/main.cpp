@@ -0,0 +1,201 @@
+/*
+flowcube-bake: headless asset pipeline entry point, no window or gl context.
+
+usage:
+    flowcube-bake skybox <in.hdr> <out.ktx2> [--quality fast|normal|high] [--no-mips] [--prefilter] [--samples N]
+    flowcube-bake flow <in.flowjournal | in.png> <out.ktx2 | out.png> [--face-size N] [--encoding rg8|rg16|octahedral]
+                       [--input-encoding rg8|rg16|octahedral] [--max-magnitude M] [--dither] [--quality fast|normal|high]
+    flowcube-bake batch <jobs.txt>
+every command takes --threads N. batch runs one command per line (without the program name), # starts a comment.
+*/
+
+#include "logger.h"
+#include "parallel.hpp"
+#include "environment/Environment.hpp"
+#include "flow/LayerStack.hpp"
+#include "flow/Journal.hpp"
+#include "flow/Export.hpp"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    constexpr unsigned DEFAULT_FLOW_FACE_SIZE = 512;
+
+    void printUsage()
+    {
+        printf(
+            "usage:\n"
+            "    flowcube-bake skybox <in.hdr> <out.ktx2> [--quality fast|normal|high] [--no-mips] [--prefilter] [--samples N]\n"
+            "    flowcube-bake flow <in.flowjournal | in.png> <out.ktx2 | out.png> [--face-size N] [--encoding rg8|rg16|octahedral]\n"
+            "                       [--input-encoding rg8|rg16|octahedral] [--max-magnitude M] [--dither] [--quality fast|normal|high]\n"
+            "    flowcube-bake batch <jobs.txt>\n"
+            "every command takes --threads N\n"
+        );
+    }
+
+    std::string toLower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        return text;
+    }
+    bc::Quality parseQuality(std::string const &name)
+    {
+        for(bc::Quality quality : bc::QUALITIES) {
+            if(name == bc::qualityToString(quality)) return quality;
+        }
+        throw std::runtime_error{"unknown quality \"" + name + "\""};
+    }
+    flow::Encoding parseEncoding(std::string const &name)
+    {
+        for(flow::Encoding encoding : flow::ENCODINGS) {
+            if(toLower(name) == toLower(flow::encodingToString(encoding))) return encoding;
+        }
+        throw std::runtime_error{"unknown encoding \"" + name + "\""};
+    }
+
+    struct Options {
+        std::vector<std::string> positional;
+        bc::Quality quality = bc::Quality::NORMAL;
+        bool mips = true;
+        bool prefilter = false;
+        unsigned samples = 64;
+        unsigned faceSize = DEFAULT_FLOW_FACE_SIZE;
+        flow::Encoding encoding = flow::Encoding::RG8;
+        flow::Encoding inputEncoding = flow::Encoding::RG8;
+        flow::EncodeOptions encodeOptions{};
+    };
+
+    Options parseOptions(std::vector<std::string> const &args)
+    {
+        Options options{};
+        for(size_t i = 1; i < args.size(); ++i) {
+            std::string const &arg = args[i];
+            auto next = [&]() -> std::string const & {
+                if(i + 1 >= args.size()) throw std::runtime_error{arg + " expects a value"};
+                return args[++i];
+            };
+            if(arg == "--quality") options.quality = parseQuality(next());
+            else if(arg == "--no-mips") options.mips = false;
+            else if(arg == "--prefilter") options.prefilter = true;
+            else if(arg == "--samples") options.samples = unsigned(std::stoul(next()));
+            else if(arg == "--face-size") options.faceSize = unsigned(std::stoul(next()));
+            else if(arg == "--encoding") options.encoding = parseEncoding(next());
+            else if(arg == "--input-encoding") options.inputEncoding = parseEncoding(next());
+            else if(arg == "--max-magnitude") options.encodeOptions.maxMagnitude = std::stof(next());
+            else if(arg == "--dither") options.encodeOptions.dither = true;
+            else if(arg == "--threads") parallel::setNumWorkers(unsigned(std::stoul(next())));
+            else if(arg.rfind("--", 0) == 0) throw std::runtime_error{"unknown option " + arg};
+            else options.positional.push_back(arg);
+        }
+        return options;
+    }
+
+    bool hasExtension(std::string const &path, char const *extension)
+    {
+        return toLower(std::filesystem::path{path}.extension().string()) == extension;
+    }
+
+    void bakeSkybox(Options const &options)
+    {
+        if(options.positional.size() != 2) throw std::runtime_error{"skybox expects <in.hdr> <out.ktx2>"};
+        // the roughness levels are the mip chain, a single level would be the unfiltered input
+        if(options.prefilter && !options.mips) throw std::runtime_error{"--prefilter needs the mip chain, it can't be combined with --no-mips"};
+        std::string const &input = options.positional[0], &output = options.positional[1];
+        auto start = std::chrono::steady_clock::now();
+
+        env::CubemapFaces faces;
+        env::convertEquirectangularToCubemap(env::loadEquirectangular(input), faces);
+        env::ExportReport report{};
+        if(options.prefilter) {
+            report = env::exportBC6H(env::prefilterGGX(faces, 0, options.samples), output, options.quality);
+        } else {
+            report = env::exportBC6H(faces, output, options.quality, options.mips);
+        }
+        LOG_INFO("%s -> %s: %ux%u, %u levels%s, %s, %zu bytes, encoded in %.2fs, %.2fs total",
+            input.c_str(), output.c_str(), faces[0].getWidth(), faces[0].getHeight(), report.levels, options.prefilter ? " prefiltered" : "",
+            bc::qualityToString(options.quality), report.bytes, report.seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    void bakeFlow(Options const &options)
+    {
+        if(options.positional.size() != 2) throw std::runtime_error{"flow expects <in.flowjournal | in.png> <out.ktx2 | out.png>"};
+        std::string const &input = options.positional[0], &output = options.positional[1];
+        auto start = std::chrono::steady_clock::now();
+
+        flow::LayerStack layers{options.faceSize};
+        if(hasExtension(input, ".png")) {
+            flow::importImage(layers, layers.addLayer("imported"), input, options.inputEncoding, options.encodeOptions);
+        } else {
+            flow::Journal::load(input).replay(layers);
+        }
+        layers.composite();
+
+        if(hasExtension(output, ".ktx2")) {
+            flow::ExportReport report = flow::exportBC5(layers, output, options.quality, options.encodeOptions);
+            LOG_INFO("%s -> %s: BC5 %s, %zu bytes, max error %.5f, rms error %.5f",
+                input.c_str(), output.c_str(), bc::qualityToString(options.quality), report.bytes, report.maxError, report.rmsError);
+        } else {
+            flow::exportImage(layers, output, options.encoding, options.encodeOptions);
+            LOG_INFO("%s -> %s: %s", input.c_str(), output.c_str(), flow::encodingToString(options.encoding));
+        }
+        LOG_INFO("%u layers at %u, %.2fs", layers.getNumLayers(), options.faceSize, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // returns false and logs instead of throwing, so a batch can carry on
+    bool run(std::vector<std::string> const &args);
+
+    void bakeBatch(Options const &options)
+    {
+        if(options.positional.size() != 1) throw std::runtime_error{"batch expects <jobs.txt>"};
+        std::ifstream file{options.positional[0]};
+        if(!file) throw std::runtime_error{"failed to open \"" + options.positional[0] + "\""};
+
+        unsigned numJobs = 0, numFailed = 0;
+        std::string line;
+        while(std::getline(file, line)) {
+            std::istringstream stream{line};
+            std::vector<std::string> args;
+            for(std::string arg; stream >> arg;) args.push_back(arg);
+            if(args.empty() || args[0][0] == '#') continue;
+            if(args[0] == "batch") throw std::runtime_error{"batches can not be nested"};
+            ++numJobs;
+            if(!run(args)) ++numFailed;
+        }
+        LOG_INFO("%u jobs, %u failed", numJobs, numFailed);
+        if(numFailed) throw std::runtime_error{std::to_string(numFailed) + " jobs failed"};
+    }
+
+    bool run(std::vector<std::string> const &args)
+    {
+        // --threads is process wide, restored so a batch line only gets the threads it asks for
+        unsigned numWorkers = parallel::getNumWorkers();
+        bool succeeded = true;
+        try {
+            Options options = parseOptions(args);
+            if(args[0] == "skybox") bakeSkybox(options);
+            else if(args[0] == "flow") bakeFlow(options);
+            else if(args[0] == "batch") bakeBatch(options);
+            else throw std::runtime_error{"unknown command \"" + args[0] + "\""};
+        } catch(std::exception const &e) {
+            LOG_ERROR("%s", e.what());
+            succeeded = false;
+        }
+        parallel::setNumWorkers(numWorkers);
+        return succeeded;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if(argc < 2) {
+        printUsage();
+        return 1;
+    }
+    return run(std::vector<std::string>(argv + 1, argv + argc)) ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+#include "Environment.hpp"
+#include "export/Ktx2.hpp"
+#include "parallel.hpp"
+#include "stb_image.h"
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <stdexcept>
+
+Bitmap<float> env::loadEquirectangular(std::filesystem::path const &filepath, bool flip)
+{
+    int width, height, numChannels;
+    stbi_set_flip_vertically_on_load(flip);
+    float *image = stbi_loadf(static_cast<char const *>(filepath.string().c_str()), &width, &height, &numChannels, 0);
+    if(!image) {
+        throw std::runtime_error{"failed to load an image: " + filepath.string()};
+    }
+
+    Bitmap<float> bitmapImage{static_cast<unsigned>(width), static_cast<unsigned>(height), static_cast<unsigned>(numChannels), image};
+    stbi_image_free(image);
+    return bitmapImage;
+}
+
+// faceID 0 - 5 in the opengl cube map order, +X, -X, +Y, -Y, +Z, -Z
+glm::vec3 faceCoordsToXYZ(unsigned x, unsigned y, unsigned faceID, unsigned faceSize) 
+{
+    float A = 2.0f * (float) x / faceSize;
+    float B = 2.0f * (float) y / faceSize;
+
+    glm::vec3 res;
+
+    switch (faceID) {
+    case 0:
+        res = glm::vec3(A - 1.0f, 1.0f, 1.0f - B);
+        break;
+    case 1:
+        res = glm::vec3(1.0f - A, -1.0f, 1.0f - B);
+        break;
+    case 2:
+        res = glm::vec3(1.0f - B, A - 1.0f, 1.0f);
+        break;
+    case 3:
+        res = glm::vec3(B - 1.0f, A - 1.0f, -1.0f);
+        break;
+    case 4:
+        res = glm::vec3(-1.0f, A - 1.0f, 1.0f - B);
+        break;
+    case 5:
+        res = glm::vec3(1.0f, 1.0f - A, 1.0f - B);
+        break;
+     
+    default:
+        assert(0);
+    }
+
+    return res;
+}
+// thanks to https://github.com/emeiri/ogldev/blob/master/Common/cubemap_texture.cpp
+void env::convertEquirectangularToCubemap(Bitmap<float> const &equir, CubemapFaces &cubemapBitmaps)
+{
+    unsigned faceSize = glm::ceil(equir.getWidth() / 4.0f);
+
+    for (unsigned i = 0; i < NUM_FACES_IN_CUBEMAP; i++) {
+        cubemapBitmaps[i] = Bitmap{faceSize, faceSize, equir.getNumComponents()};
+    }
+
+    int maxW = equir.getWidth() - 1;
+    int maxH = equir.getHeight() - 1;
+
+    for (unsigned face = 0; face < NUM_FACES_IN_CUBEMAP; face++) {
+        for (unsigned y = 0; y < faceSize; y++) {
+            for (unsigned x = 0; x < faceSize; x++) {
+                glm::vec3 P = faceCoordsToXYZ(x, y, face, faceSize);
+                float R = sqrtf(P.x * P.x + P.y * P.y);
+                float phi = atan2f(P.y, P.x);
+                float theta = atan2f(P.z, R);
+
+                // Calculate texture coordinates
+                float u = (float)((phi + M_PI) / (2.0f * M_PI));
+                float v = (float((M_PI / 2.0f - theta) / M_PI));
+
+                // Scale texture coordinates by image size
+                float U = u * equir.getWidth();
+                float V = v * equir.getHeight();
+
+                // 4-samples for bilinear interpolation
+                int U1 = glm::clamp<int>(int(floor(U)), 0, maxW);
+                int V1 = glm::clamp<int>(int(floor(V)), 0, maxH);
+                int U2 = glm::clamp<int>(U1 + 1, 0, maxW);
+                int V2 = glm::clamp<int>(V1 + 1, 0, maxH);
+
+                // Calculate the fractional part
+                float s = U - U1;
+                float t = V - V1;
+
+                // Fetch 4-samples
+                glm::vec4 BottomLeft  = equir.getPixel(U1, V1);
+                glm::vec4 BottomRight = equir.getPixel(U2, V1);
+                glm::vec4 TopLeft     = equir.getPixel(U1, V2);
+                glm::vec4 TopRight    = equir.getPixel(U2, V2);
+
+                // Bilinear interpolation
+                glm::vec4 color = BottomLeft * (1 - s) * (1 - t) + 
+                                  BottomRight * (s) * (1 - t) + 
+                                  TopLeft * (1 - s) * t + 
+                                  TopRight * (s) * (t);
+
+                cubemapBitmaps[face].setPixel(x, y, color);
+            }   // j loop
+        }   // i loop
+    }   // Face loop
+}
+namespace
+{
+    // same frame as faceCoordsToXYZ, st in [0, 1] across the face
+    glm::vec3 faceToDirection(unsigned face, glm::vec2 st)
+    {
+        glm::vec2 ab = st * 2.0f - 1.0f;
+        switch (face)
+        {
+        case 0:  return glm::vec3{ ab.x,  1, -ab.y};
+        case 1:  return glm::vec3{-ab.x, -1, -ab.y};
+        case 2:  return glm::vec3{-ab.y,  ab.x,  1};
+        case 3:  return glm::vec3{ ab.y,  ab.x, -1};
+        case 4:  return glm::vec3{-1,  ab.x, -ab.y};
+        default: return glm::vec3{ 1, -ab.x, -ab.y};
+        }
+    }
+    unsigned directionToFace(glm::vec3 dir, glm::vec2 &st)
+    {
+        glm::vec3 a = glm::abs(dir);
+        unsigned face;
+        glm::vec2 ab;
+        if(a.y >= a.x && a.y >= a.z) {
+            face = dir.y > 0 ? 0 : 1;
+            ab = glm::vec2{dir.y > 0 ? dir.x : -dir.x, -dir.z} / a.y;
+        } else if(a.z >= a.x) {
+            face = dir.z > 0 ? 2 : 3;
+            ab = glm::vec2{dir.y, dir.z > 0 ? -dir.x : dir.x} / a.z;
+        } else {
+            face = dir.x < 0 ? 4 : 5;
+            ab = glm::vec2{dir.x < 0 ? dir.y : -dir.y, -dir.z} / a.x;
+        }
+        st = ab * 0.5f + 0.5f;
+        return face;
+    }
+
+    // bilinear, clamped to the face edges
+    glm::vec4 sampleCubemap(env::CubemapFaces const &faces, glm::vec3 dir)
+    {
+        glm::vec2 st;
+        Bitmap<float> const &face = faces[directionToFace(dir, st)];
+        unsigned size = face.getWidth();
+        glm::vec2 position = glm::clamp(st * float(size) - 0.5f, glm::vec2{0}, glm::vec2{float(size - 1)});
+        glm::uvec2 p0{position};
+        glm::uvec2 p1 = glm::min(p0 + 1u, glm::uvec2{size - 1});
+        glm::vec2 t = position - glm::vec2{p0};
+        glm::vec4 top = glm::mix(face.getPixel(p0.x, p0.y), face.getPixel(p1.x, p0.y), t.x);
+        glm::vec4 bottom = glm::mix(face.getPixel(p0.x, p1.y), face.getPixel(p1.x, p1.y), t.x);
+        return glm::mix(top, bottom, t.y);
+    }
+    glm::vec4 sampleCubemapLod(std::vector<env::CubemapFaces> const &chain, glm::vec3 dir, float lod)
+    {
+        lod = glm::clamp(lod, 0.0f, float(chain.size() - 1));
+        unsigned level = unsigned(lod);
+        glm::vec4 result = sampleCubemap(chain[level], dir);
+        if(level + 1 < chain.size() && lod > float(level)) result = glm::mix(result, sampleCubemap(chain[level + 1], dir), lod - float(level));
+        return result;
+    }
+
+    glm::vec2 hammersley(unsigned i, unsigned count)
+    {
+        uint32_t bits = i;
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        return glm::vec2{float(i) / float(count), float(bits) * 2.3283064365386963e-10f};
+    }
+} // namespace
+
+std::vector<env::CubemapFaces> env::generateMipChain(CubemapFaces const &faces)
+{
+    std::vector<CubemapFaces> levels{faces};
+    while(levels.back()[0].getWidth() > 1 || levels.back()[0].getHeight() > 1) {
+        CubemapFaces const &previous = levels.back();
+        CubemapFaces next{};
+        for(unsigned face = 0; face < NUM_FACES_IN_CUBEMAP; ++face) {
+            Bitmap<float> const &source = previous[face];
+            unsigned width = std::max(source.getWidth() / 2, 1u);
+            unsigned height = std::max(source.getHeight() / 2, 1u);
+            next[face] = Bitmap<float>{width, height, source.getNumComponents()};
+            for(unsigned y = 0; y < height; ++y) {
+                for(unsigned x = 0; x < width; ++x) {
+                    unsigned x0 = std::min(2 * x, source.getWidth() - 1), x1 = std::min(2 * x + 1, source.getWidth() - 1);
+                    unsigned y0 = std::min(2 * y, source.getHeight() - 1), y1 = std::min(2 * y + 1, source.getHeight() - 1);
+                    glm::vec4 sum = source.getPixel(x0, y0) + source.getPixel(x1, y0) + source.getPixel(x0, y1) + source.getPixel(x1, y1);
+                    next[face].setPixel(x, y, sum * 0.25f);
+                }
+            }
+        }
+        levels.push_back(std::move(next));
+    }
+    return levels;
+}
+std::vector<env::CubemapFaces> env::prefilterGGX(CubemapFaces const &faces, unsigned numLevels, unsigned sampleCount)
+{
+    std::vector<CubemapFaces> chain = generateMipChain(faces);
+    if(numLevels == 0 || numLevels > chain.size()) numLevels = unsigned(chain.size());
+    sampleCount = std::max(sampleCount, 1u);
+    float const sourceSize = float(faces[0].getWidth());
+    float const texelSolidAngle = 4.0f * float(M_PI) / (6.0f * sourceSize * sourceSize);
+
+    std::vector<CubemapFaces> result{faces};
+    for(unsigned level = 1; level < numLevels; ++level) {
+        float roughness = numLevels > 1 ? float(level) / float(numLevels - 1) : 0.0f;
+        float alpha2 = roughness * roughness * roughness * roughness;
+        unsigned size = chain[level][0].getWidth();
+        CubemapFaces &out = result.emplace_back();
+        for(Bitmap<float> &face : out) face = Bitmap<float>{size, size, faces[0].getNumComponents()};
+
+        // half vectors and mip lods only depend on the sample index, the texel just rotates them
+        struct Sample { glm::vec3 halfVector; float lod; };
+        std::vector<Sample> samples;
+        for(unsigned i = 0; i < sampleCount; ++i) {
+            glm::vec2 xi = hammersley(i, sampleCount);
+            float phi = 2.0f * float(M_PI) * xi.x;
+            float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (alpha2 - 1.0f) * xi.y));
+            float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+            float d = (cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f);
+            float pdf = alpha2 / (float(M_PI) * d * d) * 0.25f;  // D * NoH / (4 VoH) with N = V
+            float sampleSolidAngle = 1.0f / (float(sampleCount) * pdf + 1e-6f);
+            float lod = 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f;
+            samples.push_back({glm::vec3{sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta}, lod});
+        }
+
+        parallel::forEach(size_t(NUM_FACES_IN_CUBEMAP) * size, [&](size_t row) {
+            unsigned face = unsigned(row / size), y = unsigned(row % size);
+            for(unsigned x = 0; x < size; ++x) {
+                glm::vec3 n = glm::normalize(faceToDirection(face, (glm::vec2{x, y} + 0.5f) / float(size)));
+                glm::vec3 up = std::abs(n.z) < 0.999f ? glm::vec3{0, 0, 1} : glm::vec3{1, 0, 0};
+                glm::vec3 tangentX = glm::normalize(glm::cross(up, n));
+                glm::vec3 tangentY = glm::cross(n, tangentX);
+
+                glm::vec4 sum{0};
+                float weight = 0;
+                for(Sample const &sample : samples) {
+                    glm::vec3 h = tangentX * sample.halfVector.x + tangentY * sample.halfVector.y + n * sample.halfVector.z;
+                    glm::vec3 l = 2.0f * glm::dot(n, h) * h - n;
+                    float nDotL = glm::dot(n, l);
+                    if(nDotL <= 0) continue;
+                    sum += sampleCubemapLod(chain, l, sample.lod) * nDotL;
+                    weight += nDotL;
+                }
+                out[face].setPixel(x, y, weight > 0 ? sum / weight : sampleCubemap(chain[level], n));
+            }
+        });
+    }
+    return result;
+}
+
+env::ExportReport env::exportBC6H(CubemapFaces const &faces, std::filesystem::path const &path, bc::Quality quality, bool mips)
+{
+    return exportBC6H(mips ? generateMipChain(faces) : std::vector<CubemapFaces>{faces}, path, quality);
+}
+env::ExportReport env::exportBC6H(std::vector<CubemapFaces> const &levels, std::filesystem::path const &path, bc::Quality quality)
+{
+    auto start = std::chrono::steady_clock::now();
+    if(levels.empty() || levels[0][0].getWidth() == 0 || levels[0][0].getWidth() != levels[0][0].getHeight())
+        throw std::runtime_error{"cubemap faces have to be square"};
+
+    ktx2::Texture texture{};
+    texture.format = ktx2::Format::BC6H_UFLOAT_BLOCK;
+    texture.width = levels[0][0].getWidth();
+    texture.height = levels[0][0].getHeight();
+    texture.faceCount = NUM_FACES_IN_CUBEMAP;
+
+    ExportReport report{};
+    for(CubemapFaces const &levelFaces : levels) {
+        std::vector<uint8_t> &level = texture.levels.emplace_back();
+        for(Bitmap<float> const &face : levelFaces) {
+            std::vector<uint8_t> blocks = bc::encodeBC6H(face.getData(), face.getWidth(), face.getHeight(), face.getNumComponents(), quality);
+            level.insert(level.end(), blocks.begin(), blocks.end());
+        }
+        report.bytes += level.size();
+    }
+    ktx2::write(path, texture);
+
+    report.levels = unsigned(texture.levels.size());
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "opengl/Bitmap.hpp"
+#include "export/BlockCompression.hpp"
+#include <array>
+#include <vector>
+#include <filesystem>
+
+/*
+cpu side of the hdr environment, no gl context needed
+*/
+namespace env
+{
+    constexpr unsigned NUM_FACES_IN_CUBEMAP = 6;
+    // +X, -X, +Y, -Y, +Z, -Z, same order as the cube map layers
+    using CubemapFaces = std::array<Bitmap<float>, NUM_FACES_IN_CUBEMAP>;
+
+    // throws std::runtime_error
+    Bitmap<float> loadEquirectangular(std::filesystem::path const &filepath, bool flip = false);
+    void convertEquirectangularToCubemap(Bitmap<float> const &equir, CubemapFaces &cubemapBitmaps);
+    // level 0 is a copy of faces, every next level is a 2x2 box filter of the previous one down to 1x1
+    std::vector<CubemapFaces> generateMipChain(CubemapFaces const &faces);
+    /*
+    GGX specular prefilter for split sum image based lighting. level i has the size of mip i and roughness i / (numLevels - 1),
+    level 0 is the source itself. every texel takes sampleCount importance samples, read from the mip chain by sample pdf.
+    numLevels 0 means the full chain
+    */
+    std::vector<CubemapFaces> prefilterGGX(CubemapFaces const &faces, unsigned numLevels = 0, unsigned sampleCount = 64);
+
+    struct ExportReport {
+        double seconds = 0;
+        size_t bytes = 0;       // compressed payload, all faces and levels
+        unsigned levels = 0;
+    };
+
+    // faces -> BC6H_UFLOAT KTX2 cubemap, with the full mip chain unless mips is false. throws std::runtime_error
+    ExportReport exportBC6H(CubemapFaces const &faces, std::filesystem::path const &path, bc::Quality quality = bc::Quality::NORMAL, bool mips = true);
+    // levels from generateMipChain or prefilterGGX
+    ExportReport exportBC6H(std::vector<CubemapFaces> const &levels, std::filesystem::path const &path, bc::Quality quality = bc::Quality::NORMAL);
+} // namespace env
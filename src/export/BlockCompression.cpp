@@ -0,0 +1,455 @@
+#include "BlockCompression.hpp"
+#include "parallel.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/packing.hpp"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BC_SSE2 1
+#endif
+
+char const *bc::qualityToString(Quality quality) noexcept
+{
+    switch (quality)
+    {
+    case Quality::FAST:   return "fast";
+    case Quality::NORMAL: return "normal";
+    case Quality::HIGH:   return "high";
+    default:              return "unknown";
+    }
+}
+
+namespace
+{
+    constexpr unsigned TEXELS_PER_BLOCK = bc::BLOCK_DIMENSION * bc::BLOCK_DIMENSION;
+
+    // e0 > e1 selects the 8 value palette, otherwise 6 values plus 0 and 255
+    void buildBC4Palette(int e0, int e1, float *palette)
+    {
+        palette[0] = float(e0);
+        palette[1] = float(e1);
+        if(e0 > e1) {
+            for(int i = 1; i <= 6; ++i) palette[i + 1] = float((7 - i) * e0 + i * e1) / 7.0f;
+        } else {
+            for(int i = 1; i <= 4; ++i) palette[i + 1] = float((5 - i) * e0 + i * e1) / 5.0f;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    // squared error of the block when every texel picks its closest palette entry
+    float getPaletteError(float const *values, float const *palette)
+    {
+#ifdef BC_SSE2
+        __m128 const v[4] = { _mm_loadu_ps(values + 0), _mm_loadu_ps(values + 4), _mm_loadu_ps(values + 8), _mm_loadu_ps(values + 12) };
+        __m128 best[4];
+        for(int j = 0; j < 4; ++j) best[j] = _mm_set1_ps(std::numeric_limits<float>::max());
+        for(int p = 0; p < 8; ++p) {
+            __m128 entry = _mm_set1_ps(palette[p]);
+            for(int j = 0; j < 4; ++j) {
+                __m128 d = _mm_sub_ps(v[j], entry);
+                best[j] = _mm_min_ps(best[j], _mm_mul_ps(d, d));
+            }
+        }
+        __m128 sum = _mm_add_ps(_mm_add_ps(best[0], best[1]), _mm_add_ps(best[2], best[3]));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+#else
+        float error = 0;
+        for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+            float best = std::numeric_limits<float>::max();
+            for(int p = 0; p < 8; ++p) best = std::min(best, (values[i] - palette[p]) * (values[i] - palette[p]));
+            error += best;
+        }
+        return error;
+#endif
+    }
+
+    // values in [0, 255]
+    void encodeBC4(float const *values, bc::Quality quality, uint8_t *dst)
+    {
+        float lo = *std::min_element(values, values + TEXELS_PER_BLOCK);
+        float hi = *std::max_element(values, values + TEXELS_PER_BLOCK);
+        int loQ = int(std::lround(lo)), hiQ = int(std::lround(hi));
+
+        int bestE0 = hiQ, bestE1 = loQ;
+        float bestError = std::numeric_limits<float>::max();
+        float palette[8];
+        auto tryEndpoints = [&](int e0, int e1) {
+            e0 = std::clamp(e0, 0, 255);
+            e1 = std::clamp(e1, 0, 255);
+            buildBC4Palette(e0, e1, palette);
+            float error = getPaletteError(values, palette);
+            if(error < bestError) {
+                bestError = error;
+                bestE0 = e0;
+                bestE1 = e1;
+            }
+        };
+
+        if(hiQ == loQ) {
+            tryEndpoints(hiQ, loQ);
+        } else {
+            int radius = quality == bc::Quality::HIGH ? 4 : quality == bc::Quality::NORMAL ? 1 : 0;
+            for(int e0 = hiQ - radius; e0 <= hiQ + radius; ++e0) {
+                for(int e1 = loQ - radius; e1 <= loQ + radius; ++e1) {
+                    if(std::clamp(e0, 0, 255) > std::clamp(e1, 0, 255)) tryEndpoints(e0, e1);
+                }
+            }
+        }
+
+        if(quality != bc::Quality::FAST && bestError > 0) {
+            // 0 and 255 come for free in the 6 value palette, fit the endpoints to the rest
+            float innerLo = 255, innerHi = 0;
+            for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+                if(values[i] < 0.5f || values[i] > 254.5f) continue;
+                innerLo = std::min(innerLo, values[i]);
+                innerHi = std::max(innerHi, values[i]);
+            }
+            if(innerLo <= innerHi) {
+                int radius = quality == bc::Quality::HIGH ? 2 : 0;
+                int a = int(std::lround(innerLo)), b = int(std::lround(innerHi));
+                for(int e0 = a - radius; e0 <= a + radius; ++e0) {
+                    for(int e1 = b - radius; e1 <= b + radius; ++e1) {
+                        if(std::clamp(e0, 0, 255) <= std::clamp(e1, 0, 255)) tryEndpoints(e0, e1);
+                    }
+                }
+            }
+        }
+
+        buildBC4Palette(bestE0, bestE1, palette);
+        uint64_t indices = 0;
+        for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+            uint64_t best = 0;
+            float bestDistance = std::numeric_limits<float>::max();
+            for(uint64_t p = 0; p < 8; ++p) {
+                float distance = std::abs(values[i] - palette[p]);
+                if(distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (3 * i);
+        }
+        dst[0] = uint8_t(bestE0);
+        dst[1] = uint8_t(bestE1);
+        for(int i = 0; i < 6; ++i) dst[2 + i] = uint8_t(indices >> (8 * i));
+    }
+
+    void decodeBC4(uint8_t const *src, float *values)
+    {
+        float palette[8];
+        buildBC4Palette(src[0], src[1], palette);
+        uint64_t indices = 0;
+        for(int i = 0; i < 6; ++i) indices |= uint64_t(src[2 + i]) << (8 * i);
+        for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+            values[i] = palette[(indices >> (3 * i)) & 7];
+        }
+    }
+
+    constexpr int BC6H_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    constexpr float BC6H_MAX_HALF = 31743.0f; // 0x7BFF, largest finite half
+
+    struct BC6HMode {
+        uint32_t bits;      // 5 bit mode field
+        int endpointBits;   // precision of both endpoints
+        int deltaBits;      // bits the second endpoint is stored with, as a delta when less than endpointBits
+    };
+    // single region modes 11 - 14
+    constexpr BC6HMode BC6H_MODES[] = { {0x03, 10, 10}, {0x07, 11, 9}, {0x0b, 12, 8}, {0x0f, 16, 4} };
+
+    // texels as half float bit patterns, planar
+    struct BC6HBlock {
+        float channels[3][TEXELS_PER_BLOCK];
+    };
+
+    struct BC6HCandidate {
+        BC6HMode const *mode = nullptr;
+        int a[3] = {}, b[3] = {};
+        uint8_t indices[TEXELS_PER_BLOCK] = {};
+        float error = std::numeric_limits<float>::max();
+    };
+
+    inline int unquantizeBC6H(int q, int bits)
+    {
+        if(bits >= 15) return q;
+        if(q == 0) return 0;
+        if(q == (1 << bits) - 1) return 0xFFFF;
+        return ((q << 16) + 0x8000) >> bits;
+    }
+    inline int finishUnquantizeBC6H(int value) { return (value * 31) >> 6; }
+
+    int quantizeBC6H(float half, int bits)
+    {
+        float unquantized = half * 64.0f / 31.0f;
+        int q = bits >= 15 ? int(std::lround(unquantized)) : int(std::lround(unquantized * float(1 << bits) / 65536.0f - 0.5f));
+        // the estimate can be one step off, keep the neighbour that decodes closest
+        int best = 0;
+        float bestError = std::numeric_limits<float>::max();
+        for(int candidate = q - 1; candidate <= q + 1; ++candidate) {
+            int clamped = std::clamp(candidate, 0, (1 << bits) - 1);
+            float error = std::abs(float(finishUnquantizeBC6H(unquantizeBC6H(clamped, bits))) - half);
+            if(error < bestError) {
+                bestError = error;
+                best = clamped;
+            }
+        }
+        return best;
+    }
+
+    // picks the closest of the 16 palette entries for every texel, returns the summed squared error
+    float evaluateBC6H(BC6HBlock const &block, int const *a, int const *b, int bits, uint8_t *indices)
+    {
+        alignas(16) float palette[3][16];
+        for(int c = 0; c < 3; ++c) {
+            int ua = unquantizeBC6H(a[c], bits), ub = unquantizeBC6H(b[c], bits);
+            for(int i = 0; i < 16; ++i) {
+                palette[c][i] = float(finishUnquantizeBC6H(((64 - BC6H_WEIGHTS[i]) * ua + BC6H_WEIGHTS[i] * ub + 32) >> 6));
+            }
+        }
+#ifdef BC_SSE2
+        __m128 total = _mm_setzero_ps();
+        for(unsigned group = 0; group < TEXELS_PER_BLOCK; group += 4) {
+            __m128 r = _mm_loadu_ps(block.channels[0] + group);
+            __m128 g = _mm_loadu_ps(block.channels[1] + group);
+            __m128 b = _mm_loadu_ps(block.channels[2] + group);
+            __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 bestIndex = _mm_setzero_ps();
+            for(int i = 0; i < 16; ++i) {
+                __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[0][i]));
+                __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[1][i]));
+                __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[2][i]));
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+                __m128 closer = _mm_cmplt_ps(distance, best);
+                best = _mm_min_ps(best, distance);
+                bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps(float(i))), _mm_andnot_ps(closer, bestIndex));
+            }
+            total = _mm_add_ps(total, best);
+            alignas(16) float found[4];
+            _mm_store_ps(found, bestIndex);
+            for(int j = 0; j < 4; ++j) indices[group + j] = uint8_t(found[j]);
+        }
+        total = _mm_add_ps(total, _mm_movehl_ps(total, total));
+        total = _mm_add_ss(total, _mm_shuffle_ps(total, total, 1));
+        return _mm_cvtss_f32(total);
+#else
+        float total = 0;
+        for(unsigned texel = 0; texel < TEXELS_PER_BLOCK; ++texel) {
+            float best = std::numeric_limits<float>::max();
+            for(int i = 0; i < 16; ++i) {
+                float distance = 0;
+                for(int c = 0; c < 3; ++c) distance += (block.channels[c][texel] - palette[c][i]) * (block.channels[c][texel] - palette[c][i]);
+                if(distance < best) {
+                    best = distance;
+                    indices[texel] = uint8_t(i);
+                }
+            }
+            total += best;
+        }
+        return total;
+#endif
+    }
+
+    void tryBC6HEndpoints(BC6HBlock const &block, BC6HMode const &mode, glm::vec3 lo, glm::vec3 hi, BC6HCandidate &best)
+    {
+        BC6HCandidate candidate{};
+        candidate.mode = &mode;
+        // keep deltas symmetric so swapping the endpoints for the anchor bit never overflows
+        int maxDelta = (1 << (mode.deltaBits - 1)) - 1;
+        for(int c = 0; c < 3; ++c) {
+            candidate.a[c] = quantizeBC6H(lo[c], mode.endpointBits);
+            candidate.b[c] = quantizeBC6H(hi[c], mode.endpointBits);
+            if(mode.deltaBits < mode.endpointBits) {
+                candidate.b[c] = candidate.a[c] + std::clamp(candidate.b[c] - candidate.a[c], -maxDelta, maxDelta);
+                candidate.b[c] = std::clamp(candidate.b[c], 0, (1 << mode.endpointBits) - 1);
+            }
+        }
+        candidate.error = evaluateBC6H(block, candidate.a, candidate.b, mode.endpointBits, candidate.indices);
+        if(candidate.error < best.error) best = candidate;
+    }
+
+    // least squares endpoints for fixed indices
+    bool refitBC6H(BC6HBlock const &block, uint8_t const *indices, glm::vec3 &lo, glm::vec3 &hi)
+    {
+        float a11 = 0, a12 = 0, a22 = 0;
+        glm::vec3 rhsA{0}, rhsB{0};
+        for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+            float t = BC6H_WEIGHTS[indices[i]] / 64.0f;
+            glm::vec3 x{block.channels[0][i], block.channels[1][i], block.channels[2][i]};
+            a11 += (1 - t) * (1 - t);
+            a12 += t * (1 - t);
+            a22 += t * t;
+            rhsA += (1 - t) * x;
+            rhsB += t * x;
+        }
+        float determinant = a11 * a22 - a12 * a12;
+        if(std::abs(determinant) < 1e-6f) return false;
+        lo = glm::clamp((a22 * rhsA - a12 * rhsB) / determinant, 0.0f, BC6H_MAX_HALF);
+        hi = glm::clamp((a11 * rhsB - a12 * rhsA) / determinant, 0.0f, BC6H_MAX_HALF);
+        return true;
+    }
+
+    void packBC6H(BC6HCandidate const &candidate, uint8_t *dst)
+    {
+        std::fill(dst, dst + bc::BLOCK_BYTES, 0);
+        unsigned position = 0;
+        auto write = [&](uint32_t value, int count) {
+            for(int i = 0; i < count; ++i, ++position) {
+                if((value >> i) & 1) dst[position >> 3] |= uint8_t(1 << (position & 7));
+            }
+        };
+        BC6HMode const &mode = *candidate.mode;
+        write(mode.bits, 5);
+        for(int c = 0; c < 3; ++c) write(uint32_t(candidate.a[c]) & 0x3FF, 10);
+        for(int c = 0; c < 3; ++c) {
+            if(mode.deltaBits == mode.endpointBits) {
+                write(uint32_t(candidate.b[c]), mode.endpointBits);
+                continue;
+            }
+            write(uint32_t(candidate.b[c] - candidate.a[c]) & ((1u << mode.deltaBits) - 1), mode.deltaBits);
+            // the endpoint bits above 10 follow the delta, highest bit first
+            for(int bit = mode.endpointBits - 1; bit >= 10; --bit) write((uint32_t(candidate.a[c]) >> bit) & 1, 1);
+        }
+        write(candidate.indices[0], 3);
+        for(unsigned i = 1; i < TEXELS_PER_BLOCK; ++i) write(candidate.indices[i], 4);
+    }
+
+    void encodeBC6HBlock(BC6HBlock const &block, bc::Quality quality, uint8_t *dst)
+    {
+        glm::vec3 lo{BC6H_MAX_HALF}, hi{0};
+        glm::vec3 mean{0};
+        for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+            glm::vec3 x{block.channels[0][i], block.channels[1][i], block.channels[2][i]};
+            lo = glm::min(lo, x);
+            hi = glm::max(hi, x);
+            mean += x / float(TEXELS_PER_BLOCK);
+        }
+
+        if(quality != bc::Quality::FAST) {
+            // principal axis by power iteration on the covariance
+            glm::mat3 covariance{0};
+            for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+                glm::vec3 d = glm::vec3{block.channels[0][i], block.channels[1][i], block.channels[2][i]} - mean;
+                covariance += glm::outerProduct(d, d);
+            }
+            glm::vec3 axis = hi - lo;
+            for(int iteration = 0; iteration < 8 && glm::dot(axis, axis) > 0; ++iteration) {
+                axis = covariance * axis;
+                axis /= glm::max(glm::max(glm::abs(axis.x), glm::abs(axis.y)), glm::max(glm::abs(axis.z), 1e-20f));
+            }
+            if(glm::dot(axis, axis) > 0) {
+                axis = glm::normalize(axis);
+                float tMin = std::numeric_limits<float>::max(), tMax = std::numeric_limits<float>::lowest();
+                for(unsigned i = 0; i < TEXELS_PER_BLOCK; ++i) {
+                    float t = glm::dot(glm::vec3{block.channels[0][i], block.channels[1][i], block.channels[2][i]} - mean, axis);
+                    tMin = std::min(tMin, t);
+                    tMax = std::max(tMax, t);
+                }
+                lo = glm::clamp(mean + axis * tMin, 0.0f, BC6H_MAX_HALF);
+                hi = glm::clamp(mean + axis * tMax, 0.0f, BC6H_MAX_HALF);
+            }
+        }
+
+        BC6HCandidate best{};
+        unsigned numModes = quality == bc::Quality::FAST ? 1 : std::size(BC6H_MODES);
+        for(unsigned m = 0; m < numModes; ++m) {
+            tryBC6HEndpoints(block, BC6H_MODES[m], lo, hi, best);
+            if(quality != bc::Quality::HIGH) continue;
+            glm::vec3 refinedLo = lo, refinedHi = hi;
+            BC6HCandidate current = best;
+            for(int iteration = 0; iteration < 3; ++iteration) {
+                if(!refitBC6H(block, current.indices, refinedLo, refinedHi)) break;
+                tryBC6HEndpoints(block, BC6H_MODES[m], refinedLo, refinedHi, current);
+            }
+            if(current.error < best.error) best = current;
+        }
+
+        // the anchor texel has no room for the top index bit
+        if(best.indices[0] >= 8) {
+            std::swap(best.a, best.b);
+            for(uint8_t &index : best.indices) index = uint8_t(15 - index);
+        }
+        packBC6H(best, dst);
+    }
+} // namespace
+
+std::vector<uint8_t> bc::encodeBC5(float const *rg, unsigned width, unsigned height, Quality quality)
+{
+    unsigned blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    unsigned blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    std::vector<uint8_t> result(getCompressedSize(width, height));
+
+    parallel::forEach(size_t(blocksX) * blocksY, [&](size_t block) {
+        unsigned blockX = unsigned(block % blocksX), blockY = unsigned(block / blocksX);
+        float red[TEXELS_PER_BLOCK], green[TEXELS_PER_BLOCK];
+        for(unsigned y = 0; y < BLOCK_DIMENSION; ++y) {
+            for(unsigned x = 0; x < BLOCK_DIMENSION; ++x) {
+                // partial blocks repeat the edge texels
+                unsigned px = std::min(blockX * BLOCK_DIMENSION + x, width - 1);
+                unsigned py = std::min(blockY * BLOCK_DIMENSION + y, height - 1);
+                float const *texel = rg + 2 * (size_t(py) * width + px);
+                red[y * BLOCK_DIMENSION + x]   = std::clamp(texel[0], 0.0f, 1.0f) * 255.0f;
+                green[y * BLOCK_DIMENSION + x] = std::clamp(texel[1], 0.0f, 1.0f) * 255.0f;
+            }
+        }
+        uint8_t *dst = result.data() + block * BLOCK_BYTES;
+        encodeBC4(red, quality, dst);
+        encodeBC4(green, quality, dst + BLOCK_BYTES / 2);
+    }, blocksX);
+
+    return result;
+}
+
+void bc::decodeBC5(uint8_t const *blocks, unsigned width, unsigned height, float *rg)
+{
+    unsigned blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    unsigned blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    for(unsigned blockY = 0; blockY < blocksY; ++blockY) {
+        for(unsigned blockX = 0; blockX < blocksX; ++blockX) {
+            uint8_t const *src = blocks + (size_t(blockY) * blocksX + blockX) * BLOCK_BYTES;
+            float red[TEXELS_PER_BLOCK], green[TEXELS_PER_BLOCK];
+            decodeBC4(src, red);
+            decodeBC4(src + BLOCK_BYTES / 2, green);
+            for(unsigned y = 0; y < BLOCK_DIMENSION; ++y) {
+                for(unsigned x = 0; x < BLOCK_DIMENSION; ++x) {
+                    unsigned px = blockX * BLOCK_DIMENSION + x, py = blockY * BLOCK_DIMENSION + y;
+                    if(px >= width || py >= height) continue;
+                    float *texel = rg + 2 * (size_t(py) * width + px);
+                    texel[0] = red[y * BLOCK_DIMENSION + x] / 255.0f;
+                    texel[1] = green[y * BLOCK_DIMENSION + x] / 255.0f;
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> bc::encodeBC6H(float const *pixels, unsigned width, unsigned height, unsigned numComponents, Quality quality)
+{
+    unsigned blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    unsigned blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+    std::vector<uint8_t> result(getCompressedSize(width, height));
+
+    parallel::forEach(size_t(blocksX) * blocksY, [&](size_t block) {
+        unsigned blockX = unsigned(block % blocksX), blockY = unsigned(block / blocksX);
+        BC6HBlock texels;
+        for(unsigned y = 0; y < BLOCK_DIMENSION; ++y) {
+            for(unsigned x = 0; x < BLOCK_DIMENSION; ++x) {
+                unsigned px = std::min(blockX * BLOCK_DIMENSION + x, width - 1);
+                unsigned py = std::min(blockY * BLOCK_DIMENSION + y, height - 1);
+                float const *texel = pixels + (size_t(py) * width + px) * numComponents;
+                for(unsigned c = 0; c < 3; ++c) {
+                    float value = texel[std::min(c, numComponents - 1)];
+                    // nan and negatives go to 0, overflow to the largest finite half
+                    texels.channels[c][y * BLOCK_DIMENSION + x] = value > 0 ? float(std::min<unsigned>(glm::packHalf1x16(value), 0x7BFF)) : 0.0f;
+                }
+            }
+        }
+        encodeBC6HBlock(texels, quality, result.data() + block * BLOCK_BYTES);
+    }, blocksX);
+
+    return result;
+}
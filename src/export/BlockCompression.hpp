@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+cpu block compression. blocks are 4x4 texels, 16 bytes, stored row major.
+encoders are deterministic: the same input and quality always give the same bytes, whatever the thread count.
+*/
+namespace bc
+{
+    constexpr unsigned BLOCK_DIMENSION = 4;
+    constexpr size_t BLOCK_BYTES = 16;
+
+    enum class Quality {
+        FAST,       // endpoints from the block bounds, 8 value BC4 palette only
+        NORMAL,     // small endpoint search around the bounds, both BC4 palette modes
+        HIGH        // wide endpoint search, both BC4 palette modes
+    };
+    constexpr Quality QUALITIES[] = { Quality::FAST, Quality::NORMAL, Quality::HIGH };
+    char const *qualityToString(Quality quality) noexcept;
+
+    inline size_t getCompressedSize(unsigned width, unsigned height) noexcept
+    {
+        return size_t((width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION) * ((height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION) * BLOCK_BYTES;
+    }
+
+    // rg holds width * height interleaved unorm pairs in [0, 1]
+    std::vector<uint8_t> encodeBC5(float const *rg, unsigned width, unsigned height, Quality quality = Quality::NORMAL);
+    void decodeBC5(uint8_t const *blocks, unsigned width, unsigned height, float *rg);
+
+    /*
+    BC6H unsigned float. only the single region modes (11 - 14) are used:
+    fast takes mode 11 with bounding box endpoints, normal fits the principal axis and picks the best of modes 11 - 14,
+    high adds least squares endpoint refinement on top. error is measured on the half float bit patterns, roughly log space.
+    pixels holds width * height texels of numComponents floats, rgb is read, negatives clamp to 0
+    */
+    std::vector<uint8_t> encodeBC6H(float const *pixels, unsigned width, unsigned height, unsigned numComponents, Quality quality = Quality::NORMAL);
+} // namespace bc
@@ -0,0 +1,127 @@
+#include "Ktx2.hpp"
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint8_t IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    constexpr size_t HEADER_SIZE = 80;
+    constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+    constexpr size_t BLOCK_BYTES = 16;
+
+    // khronos data format descriptor enumerants
+    constexpr uint32_t KHR_DF_MODEL_BC5 = 132;
+    constexpr uint32_t KHR_DF_MODEL_BC6H = 133;
+    constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+    constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+    constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_FLOAT = 0x80;
+
+    void append32(std::vector<uint8_t> &buffer, uint32_t value)
+    {
+        for(int i = 0; i < 4; ++i) buffer.push_back(uint8_t(value >> (8 * i)));
+    }
+    void store32(std::vector<uint8_t> &buffer, size_t offset, uint32_t value)
+    {
+        for(int i = 0; i < 4; ++i) buffer[offset + i] = uint8_t(value >> (8 * i));
+    }
+    void store64(std::vector<uint8_t> &buffer, size_t offset, uint64_t value)
+    {
+        for(int i = 0; i < 8; ++i) buffer[offset + i] = uint8_t(value >> (8 * i));
+    }
+    void pad(std::vector<uint8_t> &buffer, size_t alignment)
+    {
+        while(buffer.size() % alignment) buffer.push_back(0);
+    }
+
+    struct Sample {
+        uint32_t bitOffset, bitLength, channel, qualifiers, lower, upper;
+    };
+    void appendDataFormatDescriptor(std::vector<uint8_t> &buffer, ktx2::Format format)
+    {
+        uint32_t model = 0;
+        std::vector<Sample> samples;
+        switch (format)
+        {
+        case ktx2::Format::BC5_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC5;
+            samples = { {0, 64, 0, 0, 0, 0xFFFFFFFF}, {64, 64, 1, 0, 0, 0xFFFFFFFF} };
+            break;
+        case ktx2::Format::BC6H_UFLOAT_BLOCK:
+            model = KHR_DF_MODEL_BC6H;
+            samples = { {0, 128, 0, KHR_DF_SAMPLE_DATATYPE_FLOAT, 0, 0x7F800000} };
+            break;
+        }
+        uint32_t blockSize = 24 + 16 * uint32_t(samples.size());
+        append32(buffer, 4 + blockSize);                     // dfdTotalSize
+        append32(buffer, 0);                                 // vendorId, descriptorType
+        append32(buffer, 2 | (blockSize << 16));             // versionNumber, descriptorBlockSize
+        append32(buffer, model | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+        append32(buffer, 3 | (3 << 8));                      // 4x4x1x1 texel blocks
+        append32(buffer, BLOCK_BYTES);                       // bytesPlane0
+        append32(buffer, 0);
+        for(Sample const &sample : samples) {
+            append32(buffer, sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24) | (sample.qualifiers << 24));
+            append32(buffer, 0);                             // sample position
+            append32(buffer, sample.lower);
+            append32(buffer, sample.upper);
+        }
+    }
+    void appendKeyValue(std::vector<uint8_t> &buffer, char const *key, char const *value)
+    {
+        uint32_t length = uint32_t(std::strlen(key) + 1 + std::strlen(value) + 1);
+        append32(buffer, length);
+        buffer.insert(buffer.end(), key, key + std::strlen(key) + 1);
+        buffer.insert(buffer.end(), value, value + std::strlen(value) + 1);
+        pad(buffer, 4);
+    }
+} // namespace
+
+void ktx2::write(std::filesystem::path const &path, Texture const &texture)
+{
+    if(texture.levels.empty() || texture.width == 0 || texture.height == 0)
+        throw std::runtime_error{"ktx2: empty texture"};
+
+    std::vector<uint8_t> buffer;
+    buffer.insert(buffer.end(), std::begin(IDENTIFIER), std::end(IDENTIFIER));
+    append32(buffer, static_cast<uint32_t>(texture.format));
+    append32(buffer, 1);                                     // typeSize
+    append32(buffer, texture.width);
+    append32(buffer, texture.height);
+    append32(buffer, 0);                                     // pixelDepth
+    append32(buffer, 0);                                     // layerCount
+    append32(buffer, texture.faceCount);
+    append32(buffer, uint32_t(texture.levels.size()));
+    append32(buffer, 0);                                     // supercompressionScheme
+    size_t const indexOffset = buffer.size();
+    buffer.resize(HEADER_SIZE + LEVEL_INDEX_ENTRY_SIZE * texture.levels.size(), 0);
+
+    size_t dfdOffset = buffer.size();
+    appendDataFormatDescriptor(buffer, texture.format);
+    size_t kvdOffset = buffer.size();
+    appendKeyValue(buffer, "KTXorientation", "rd");
+    appendKeyValue(buffer, "KTXwriter", "flow cubemap editor");
+    size_t kvdLength = buffer.size() - kvdOffset;
+
+    store32(buffer, indexOffset + 0, uint32_t(dfdOffset));
+    store32(buffer, indexOffset + 4, uint32_t(kvdOffset - dfdOffset));
+    store32(buffer, indexOffset + 8, uint32_t(kvdOffset));
+    store32(buffer, indexOffset + 12, uint32_t(kvdLength));
+    store64(buffer, indexOffset + 16, 0);                    // no supercompression global data
+    store64(buffer, indexOffset + 24, 0);
+
+    // mip padding: smallest level first, each aligned to lcm(block size, 4)
+    for(size_t level = texture.levels.size(); level-- > 0;) {
+        std::vector<uint8_t> const &data = texture.levels[level];
+        pad(buffer, BLOCK_BYTES);
+        size_t entry = HEADER_SIZE + LEVEL_INDEX_ENTRY_SIZE * level;
+        store64(buffer, entry + 0, buffer.size());
+        store64(buffer, entry + 8, data.size());
+        store64(buffer, entry + 16, data.size());
+        buffer.insert(buffer.end(), data.begin(), data.end());
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    if(!file.write(reinterpret_cast<char const *>(buffer.data()), std::streamsize(buffer.size())))
+        throw std::runtime_error{"failed to write \"" + path.string() + "\""};
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+/*
+minimal KTX 2.0 writer for block compressed 2d textures and cubemaps, no supercompression.
+https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+*/
+namespace ktx2
+{
+    // values are the matching VkFormat enumerants
+    enum class Format : uint32_t {
+        BC5_UNORM_BLOCK = 141,
+        BC6H_UFLOAT_BLOCK = 143
+    };
+
+    struct Texture {
+        Format format = Format::BC5_UNORM_BLOCK;
+        unsigned width = 0;
+        unsigned height = 0;
+        unsigned faceCount = 1;     // 6 for cubemaps
+        // level 0 first, every level holds its faces back to back in +X, -X, +Y, -Y, +Z, -Z order
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+    // throws std::runtime_error
+    void write(std::filesystem::path const &path, Texture const &texture);
+} // namespace ktx2
@@ -0,0 +1,68 @@
+#pragma once
+#include "glm/glm.hpp"
+
+/*
+cube face addressing, follows the opengl cube map convention (+X, -X, +Y, -Y, +Z, -Z).
+uv is in [0, 1], u goes along the face's s axis, v along the t axis (t = 0 is the first row uploaded).
+*/
+namespace flow
+{
+    constexpr unsigned NUM_FACES = 6;
+
+    struct FaceCoord {
+        unsigned face = 0;
+        glm::vec2 uv{0};
+    };
+
+    struct FaceBasis {
+        glm::vec3 normal;
+        glm::vec3 s;
+        glm::vec3 t;
+    };
+
+    inline FaceBasis getFaceBasis(unsigned face)
+    {
+        switch (face) {
+        case 0:  return { { 1, 0, 0}, { 0, 0,-1}, { 0,-1, 0} };
+        case 1:  return { {-1, 0, 0}, { 0, 0, 1}, { 0,-1, 0} };
+        case 2:  return { { 0, 1, 0}, { 1, 0, 0}, { 0, 0, 1} };
+        case 3:  return { { 0,-1, 0}, { 1, 0, 0}, { 0, 0,-1} };
+        case 4:  return { { 0, 0, 1}, { 1, 0, 0}, { 0,-1, 0} };
+        default: return { { 0, 0,-1}, {-1, 0, 0}, { 0,-1, 0} };
+        }
+    }
+
+    inline glm::vec3 faceToDirection(unsigned face, glm::vec2 uv)
+    {
+        FaceBasis basis = getFaceBasis(face);
+        glm::vec2 st = uv * 2.0f - 1.0f;
+        return glm::normalize(basis.normal + basis.s * st.x + basis.t * st.y);
+    }
+
+    inline FaceCoord directionToFace(glm::vec3 dir)
+    {
+        glm::vec3 a = glm::abs(dir);
+        unsigned face;
+        if(a.x >= a.y && a.x >= a.z) face = dir.x >= 0 ? 0 : 1;
+        else if(a.y >= a.z)          face = dir.y >= 0 ? 2 : 3;
+        else                         face = dir.z >= 0 ? 4 : 5;
+
+        FaceBasis basis = getFaceBasis(face);
+        float ma = glm::dot(dir, basis.normal);
+        glm::vec2 st{glm::dot(dir, basis.s) / ma, glm::dot(dir, basis.t) / ma};
+        return FaceCoord{face, glm::clamp(st * 0.5f + 0.5f, glm::vec2{0.0f}, glm::vec2{1.0f})};
+    }
+
+    // world space tangent vector -> face space flow
+    inline glm::vec2 tangentToFace(unsigned face, glm::vec3 tangent)
+    {
+        FaceBasis basis = getFaceBasis(face);
+        return glm::vec2{glm::dot(tangent, basis.s), glm::dot(tangent, basis.t)};
+    }
+    // face space flow -> world space tangent vector
+    inline glm::vec3 faceToTangent(unsigned face, glm::vec2 flow)
+    {
+        FaceBasis basis = getFaceBasis(face);
+        return basis.s * flow.x + basis.t * flow.y;
+    }
+} // namespace flow
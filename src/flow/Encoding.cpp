@@ -0,0 +1,408 @@
+#include "Encoding.hpp"
+#include "LayerStack.hpp"
+#include <cmath>
+#include <array>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLOW_SSE2 1
+#endif
+
+char const *flow::encodingToString(Encoding encoding) noexcept
+{
+    switch (encoding)
+    {
+    case Encoding::RG8:        return "RG8";
+    case Encoding::RG16:       return "RG16";
+    case Encoding::OCTAHEDRAL: return "octahedral";
+    default:                   return "unknown";
+    }
+}
+size_t flow::getTexelSize(Encoding encoding) noexcept
+{
+    switch (encoding)
+    {
+    case Encoding::RG8:        return 2;
+    case Encoding::RG16:       return 4;
+    case Encoding::OCTAHEDRAL: return 4;
+    default:                   return 0;
+    }
+}
+
+// void-and-cluster, see Ulichney 1993. the last phase just keeps filling the largest void
+float const *flow::getBlueNoise() noexcept
+{
+    static std::array<float, BLUE_NOISE_SIZE * BLUE_NOISE_SIZE> const noise = [] {
+        constexpr int N = BLUE_NOISE_SIZE;
+        constexpr float SIGMA = 1.5f;
+        std::array<float, N * N> kernel{};  // toroidal gaussian indexed by offset
+        for(int y = 0; y < N; ++y) {
+            for(int x = 0; x < N; ++x) {
+                float dx = float(glm::min(x, N - x)), dy = float(glm::min(y, N - y));
+                kernel[y * N + x] = std::exp(-(dx * dx + dy * dy) / (2 * SIGMA * SIGMA));
+            }
+        }
+        std::array<uint8_t, N * N> pattern{};
+        std::array<float, N * N> energy{};
+        auto splat = [&](int index, float sign) {
+            int px = index % N, py = index / N;
+            for(int y = 0; y < N; ++y) {
+                for(int x = 0; x < N; ++x) {
+                    energy[y * N + x] += sign * kernel[((y - py + N) % N) * N + (x - px + N) % N];
+                }
+            }
+        };
+        auto extreme = [&](bool ones, bool tightest) {
+            int best = -1;
+            for(int i = 0; i < N * N; ++i) {
+                if(bool(pattern[i]) != ones) continue;
+                if(best < 0 || (tightest ? energy[i] > energy[best] : energy[i] < energy[best])) best = i;
+            }
+            return best;
+        };
+
+        std::mt19937 generator{0x5eed};
+        int numOnes = N * N / 10;
+        for(int placed = 0; placed < numOnes;) {
+            int index = std::uniform_int_distribution<int>{0, N * N - 1}(generator);
+            if(pattern[index]) continue;
+            pattern[index] = 1;
+            splat(index, 1);
+            ++placed;
+        }
+        for(int iteration = 0; iteration < N * N; ++iteration) { // relax the initial pattern
+            int cluster = extreme(true, true);
+            pattern[cluster] = 0; splat(cluster, -1);
+            int void_ = extreme(false, false);
+            pattern[void_] = 1; splat(void_, 1);
+            if(void_ == cluster) break;
+        }
+
+        std::array<float, N * N> ranks{};
+        std::array<uint8_t, N * N> initial = pattern;
+        std::array<float, N * N> initialEnergy = energy;
+        for(int rank = numOnes - 1; rank >= 0; --rank) {
+            int cluster = extreme(true, true);
+            pattern[cluster] = 0; splat(cluster, -1);
+            ranks[cluster] = float(rank);
+        }
+        pattern = initial;
+        energy = initialEnergy;
+        for(int rank = numOnes; rank < N * N; ++rank) {
+            int void_ = extreme(false, false);
+            pattern[void_] = 1; splat(void_, 1);
+            ranks[void_] = float(rank);
+        }
+        for(float &rank : ranks) rank = (rank + 0.5f) / float(N * N);
+        return ranks;
+    }();
+    return noise.data();
+}
+
+namespace
+{
+    inline float quantize(float v, float maxValue) { return std::nearbyint(glm::clamp(v, 0.0f, maxValue)); }
+    inline glm::vec2 signNotZero(glm::vec2 v) { return glm::vec2{v.x >= 0 ? 1.0f : -1.0f, v.y >= 0 ? 1.0f : -1.0f}; }
+
+    void encodeOctahedralTexel(flow::FaceBasis const &basis, glm::vec2 value, float maxMagnitude, uint8_t *dst)
+    {
+        glm::vec3 t = basis.s * value.x + basis.t * value.y;
+        float magnitude = glm::length(t);
+        float l1 = glm::abs(t.x) + glm::abs(t.y) + glm::abs(t.z);
+        glm::vec3 n = l1 > 0 ? t / l1 : glm::vec3{0};
+        glm::vec2 oct{n.x, n.y};
+        if(n.z < 0) oct = (1.0f - glm::abs(glm::vec2{oct.y, oct.x})) * signNotZero(oct);
+        dst[0] = uint8_t(quantize((oct.x * 0.5f + 0.5f) * 255, 255));
+        dst[1] = uint8_t(quantize((oct.y * 0.5f + 0.5f) * 255, 255));
+        dst[2] = uint8_t(quantize(magnitude / maxMagnitude * 255, 255));
+        dst[3] = 255;
+    }
+    glm::vec2 decodeOctahedralTexel(flow::FaceBasis const &basis, uint8_t const *src, float maxMagnitude)
+    {
+        glm::vec2 oct = glm::vec2{src[0], src[1]} / 255.0f * 2.0f - 1.0f;
+        glm::vec3 n{oct, 1 - glm::abs(oct.x) - glm::abs(oct.y)};
+        float t = glm::max(-n.z, 0.0f);
+        n.x += n.x >= 0 ? -t : t;
+        n.y += n.y >= 0 ? -t : t;
+        n = glm::normalize(n) * (src[2] / 255.0f * maxMagnitude);
+        return glm::vec2{glm::dot(n, basis.s), glm::dot(n, basis.t)};
+    }
+
+    // interleaved per channel dither offsets in LSB units for one row
+    void fillDitherRow(unsigned y, unsigned count, float *dst)
+    {
+        float const *noise = flow::getBlueNoise();
+        constexpr unsigned N = flow::BLUE_NOISE_SIZE;
+        static_assert((N & (N - 1)) == 0);
+        float const *rowR = noise + (y & (N - 1)) * N;
+        float const *rowG = noise + ((y + N / 2) & (N - 1)) * N;
+        for(unsigned x = 0; x < count; ++x) {
+            dst[2 * x + 0] = rowR[x & (N - 1)] - 0.5f;
+            dst[2 * x + 1] = rowG[(x + N / 2) & (N - 1)] - 0.5f;
+        }
+    }
+
+    void encodeRowRG(glm::vec2 const *src, unsigned count, float maxValue, float maxMagnitude, float const *dither, uint8_t *dst8, uint16_t *dst16)
+    {
+        float const *s = &src[0].x;
+        float const scale = maxValue * 0.5f / maxMagnitude;
+        float const bias = maxValue * 0.5f;
+        unsigned i = 0;
+#ifdef FLOW_SSE2
+        __m128 const scale4 = _mm_set1_ps(scale);
+        __m128 const bias4 = _mm_set1_ps(bias);
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const max4 = _mm_set1_ps(maxValue);
+        // four texels per iteration
+        for(; i + 4 <= count; i += 4) {
+            __m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s + 2 * i + 0), scale4), bias4);
+            __m128 b = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s + 2 * i + 4), scale4), bias4);
+            if(dither) {
+                a = _mm_add_ps(a, _mm_loadu_ps(dither + 2 * i + 0));
+                b = _mm_add_ps(b, _mm_loadu_ps(dither + 2 * i + 4));
+            }
+            __m128i qa = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, zero), max4));
+            __m128i qb = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, zero), max4));
+            if(dst8) {
+                __m128i packed = _mm_packus_epi16(_mm_packs_epi32(qa, qb), _mm_setzero_si128());
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst8 + 2 * i), packed);
+            } else {
+                // no unsigned 32 -> 16 pack before SSE4.1, shift into signed range and back
+                __m128i const offset = _mm_set1_epi32(32768);
+                __m128i packed = _mm_packs_epi32(_mm_sub_epi32(qa, offset), _mm_sub_epi32(qb, offset));
+                packed = _mm_xor_si128(packed, _mm_set1_epi16(short(0x8000)));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst16 + 2 * i), packed);
+            }
+        }
+#endif
+        for(i *= 2; i < 2 * count; ++i) {
+            float q = quantize(s[i] * scale + bias + (dither ? dither[i] : 0), maxValue);
+            if(dst8) dst8[i] = uint8_t(q);
+            else     dst16[i] = uint16_t(q);
+        }
+    }
+
+    void decodeRowRG(uint8_t const *src8, uint16_t const *src16, unsigned count, float maxValue, float maxMagnitude, glm::vec2 *dst)
+    {
+        float *d = &dst[0].x;
+        float const scale = 2 * maxMagnitude / maxValue;
+        unsigned i = 0;
+#ifdef FLOW_SSE2
+        __m128 const scale4 = _mm_set1_ps(scale);
+        __m128 const bias4 = _mm_set1_ps(-maxMagnitude);
+        __m128i const zero = _mm_setzero_si128();
+        for(; i + 4 <= count; i += 4) {
+            __m128i words = src8
+                ? _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(src8 + 2 * i)), zero)
+                : _mm_loadu_si128(reinterpret_cast<__m128i const *>(src16 + 2 * i));
+            __m128 a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+            __m128 b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+            _mm_storeu_ps(d + 2 * i + 0, _mm_add_ps(_mm_mul_ps(a, scale4), bias4));
+            _mm_storeu_ps(d + 2 * i + 4, _mm_add_ps(_mm_mul_ps(b, scale4), bias4));
+        }
+#endif
+        for(i *= 2; i < 2 * count; ++i) {
+            d[i] = float(src8 ? src8[i] : src16[i]) * scale - maxMagnitude;
+        }
+    }
+
+#ifdef FLOW_SSE2
+    inline __m128 abs4(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+    // +-1 with the sign of v, zero counts as positive
+    inline __m128 signNotZero4(__m128 v) { return _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f)); }
+    inline __m128 select4(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+
+    void encodeRowOctahedral(flow::FaceBasis const &basis, glm::vec2 const *src, unsigned count, float maxMagnitude, uint8_t *dst)
+    {
+        unsigned i = 0;
+#ifdef FLOW_SSE2
+        float const *s = &src[0].x;
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const one = _mm_set1_ps(1.0f);
+        __m128 const half = _mm_set1_ps(0.5f);
+        __m128 const max4 = _mm_set1_ps(255.0f);
+        __m128 const magnitudeScale = _mm_set1_ps(255.0f / maxMagnitude);
+        // four texels per iteration, deinterleaved into x and y lanes
+        for(; i + 4 <= count; i += 4) {
+            __m128 a = _mm_loadu_ps(s + 2 * i + 0);
+            __m128 b = _mm_loadu_ps(s + 2 * i + 4);
+            __m128 fx = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 fy = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            __m128 tx = _mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(basis.s.x)), _mm_mul_ps(fy, _mm_set1_ps(basis.t.x)));
+            __m128 ty = _mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(basis.s.y)), _mm_mul_ps(fy, _mm_set1_ps(basis.t.y)));
+            __m128 tz = _mm_add_ps(_mm_mul_ps(fx, _mm_set1_ps(basis.s.z)), _mm_mul_ps(fy, _mm_set1_ps(basis.t.z)));
+
+            __m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz)));
+            __m128 l1 = _mm_add_ps(_mm_add_ps(abs4(tx), abs4(ty)), abs4(tz));
+            __m128 valid = _mm_cmpgt_ps(l1, zero);
+            __m128 invL1 = _mm_and_ps(valid, _mm_div_ps(one, _mm_or_ps(l1, _mm_andnot_ps(valid, one))));
+            __m128 nx = _mm_mul_ps(tx, invL1);
+            __m128 ny = _mm_mul_ps(ty, invL1);
+            __m128 nz = _mm_mul_ps(tz, invL1);
+
+            __m128 lower = _mm_cmplt_ps(nz, zero);
+            __m128 wx = _mm_mul_ps(_mm_sub_ps(one, abs4(ny)), signNotZero4(nx));
+            __m128 wy = _mm_mul_ps(_mm_sub_ps(one, abs4(nx)), signNotZero4(ny));
+            __m128 ox = select4(lower, wx, nx);
+            __m128 oy = select4(lower, wy, ny);
+
+            __m128 r = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ox, half), half), max4);
+            __m128 g = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(oy, half), half), max4);
+            __m128 m = _mm_mul_ps(magnitude, magnitudeScale);
+            __m128i qr = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(r, zero), max4));
+            __m128i qg = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(g, zero), max4));
+            __m128i qm = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(m, zero), max4));
+            __m128i texels = _mm_or_si128(
+                _mm_or_si128(qr, _mm_slli_epi32(qg, 8)),
+                _mm_or_si128(_mm_slli_epi32(qm, 16), _mm_set1_epi32(int(0xFF000000)))
+            );
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * i), texels);
+        }
+#endif
+        for(; i < count; ++i) {
+            encodeOctahedralTexel(basis, src[i], maxMagnitude, dst + 4 * i);
+        }
+    }
+
+    void decodeRowOctahedral(flow::FaceBasis const &basis, uint8_t const *src, unsigned count, float maxMagnitude, glm::vec2 *dst)
+    {
+        unsigned i = 0;
+#ifdef FLOW_SSE2
+        float *d = &dst[0].x;
+        __m128i const byteMask = _mm_set1_epi32(0xFF);
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const one = _mm_set1_ps(1.0f);
+        __m128 const octScale = _mm_set1_ps(2.0f / 255.0f);
+        __m128 const magnitudeScale = _mm_set1_ps(maxMagnitude / 255.0f);
+        for(; i + 4 <= count; i += 4) {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 4 * i));
+            __m128 ox = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(texels, byteMask)), octScale), one);
+            __m128 oy = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8), byteMask)), octScale), one);
+            __m128 magnitude = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 16), byteMask)), magnitudeScale);
+
+            __m128 nz = _mm_sub_ps(_mm_sub_ps(one, abs4(ox)), abs4(oy));
+            __m128 t = _mm_max_ps(_mm_sub_ps(zero, nz), zero);
+            __m128 nx = _mm_sub_ps(ox, _mm_mul_ps(t, signNotZero4(ox)));
+            __m128 ny = _mm_sub_ps(oy, _mm_mul_ps(t, signNotZero4(oy)));
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+            __m128 k = _mm_div_ps(magnitude, length);
+            nx = _mm_mul_ps(nx, k);
+            ny = _mm_mul_ps(ny, k);
+            nz = _mm_mul_ps(nz, k);
+
+            __m128 fx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(basis.s.x)), _mm_mul_ps(ny, _mm_set1_ps(basis.s.y))), _mm_mul_ps(nz, _mm_set1_ps(basis.s.z)));
+            __m128 fy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(basis.t.x)), _mm_mul_ps(ny, _mm_set1_ps(basis.t.y))), _mm_mul_ps(nz, _mm_set1_ps(basis.t.z)));
+            _mm_storeu_ps(d + 2 * i + 0, _mm_unpacklo_ps(fx, fy));
+            _mm_storeu_ps(d + 2 * i + 4, _mm_unpackhi_ps(fx, fy));
+        }
+#endif
+        for(; i < count; ++i) {
+            dst[i] = decodeOctahedralTexel(basis, src + 4 * i, maxMagnitude);
+        }
+    }
+} // namespace
+
+std::vector<uint8_t> flow::encodeFace(unsigned face, glm::vec2 const *src, unsigned size, Encoding encoding, EncodeOptions const &options)
+{
+    size_t texelSize = getTexelSize(encoding);
+    std::vector<uint8_t> result(size_t(size) * size * texelSize);
+    std::vector<float> dither;
+    if(options.dither && encoding == Encoding::RG8) dither.resize(size_t(size) * 2);
+    FaceBasis basis = getFaceBasis(face);
+
+    for(unsigned y = 0; y < size; ++y) {
+        glm::vec2 const *row = src + size_t(y) * size;
+        uint8_t *dst = result.data() + size_t(y) * size * texelSize;
+        switch (encoding)
+        {
+        case Encoding::RG8:
+            if(!dither.empty()) fillDitherRow(y, size, dither.data());
+            encodeRowRG(row, size, 255.0f, options.maxMagnitude, dither.empty() ? nullptr : dither.data(), dst, nullptr);
+            break;
+        case Encoding::RG16:
+            encodeRowRG(row, size, 65535.0f, options.maxMagnitude, nullptr, nullptr, reinterpret_cast<uint16_t *>(dst));
+            break;
+        case Encoding::OCTAHEDRAL:
+            encodeRowOctahedral(basis, row, size, options.maxMagnitude, dst);
+            break;
+        }
+    }
+    return result;
+}
+
+void flow::decodeFace(unsigned face, uint8_t const *src, unsigned size, Encoding encoding, glm::vec2 *dst, EncodeOptions const &options)
+{
+    size_t texelSize = getTexelSize(encoding);
+    FaceBasis basis = getFaceBasis(face);
+    for(unsigned y = 0; y < size; ++y) {
+        uint8_t const *row = src + size_t(y) * size * texelSize;
+        glm::vec2 *out = dst + size_t(y) * size;
+        switch (encoding)
+        {
+        case Encoding::RG8:
+            decodeRowRG(row, nullptr, size, 255.0f, options.maxMagnitude, out);
+            break;
+        case Encoding::RG16:
+            decodeRowRG(nullptr, reinterpret_cast<uint16_t const *>(row), size, 65535.0f, options.maxMagnitude, out);
+            break;
+        case Encoding::OCTAHEDRAL:
+            decodeRowOctahedral(basis, row, size, options.maxMagnitude, out);
+            break;
+        }
+    }
+}
+
+flow::RoundTripReport flow::benchmarkRoundTrip(LayerStack const &layers, Encoding encoding, EncodeOptions const &options, unsigned iterations)
+{
+    using clock = std::chrono::steady_clock;
+    RoundTripReport report{};
+    report.encoding = encoding;
+    unsigned size = layers.getFaceSize();
+    std::array<std::vector<uint8_t>, NUM_FACES> encoded;
+    std::vector<glm::vec2> decoded(size_t(size) * size);
+    iterations = glm::max(iterations, 1u);
+    getBlueNoise(); // generated on first use, keep it out of the timings
+
+    double encodeSeconds = 0, decodeSeconds = 0;
+    double squaredError = 0;
+    for(unsigned iteration = 0; iteration < iterations; ++iteration) {
+        for(unsigned face = 0; face < NUM_FACES; ++face) {
+            auto start = clock::now();
+            encoded[face] = encodeFace(face, layers.getComposite(face).data(), size, encoding, options);
+            encodeSeconds += std::chrono::duration<double>(clock::now() - start).count();
+
+            start = clock::now();
+            decodeFace(face, encoded[face].data(), size, encoding, decoded.data(), options);
+            decodeSeconds += std::chrono::duration<double>(clock::now() - start).count();
+
+            if(iteration != 0) continue;
+            std::vector<glm::vec2> const &original = layers.getComposite(face);
+            for(size_t i = 0; i < decoded.size(); ++i) {
+                // values past maxMagnitude clip by design, measure against the clamped input
+                glm::vec2 expected = original[i];
+                if(encoding == Encoding::OCTAHEDRAL) {
+                    float length = glm::length(expected);
+                    if(length > options.maxMagnitude) expected *= options.maxMagnitude / length;
+                } else {
+                    expected = glm::clamp(expected, -options.maxMagnitude, options.maxMagnitude);
+                }
+                float error = glm::length(decoded[i] - expected);
+                report.maxError = glm::max(report.maxError, error);
+                squaredError += double(error) * error;
+                if(glm::length(expected) > options.maxMagnitude * 0.01f && glm::length(decoded[i]) > 0) {
+                    float cosAngle = glm::dot(glm::normalize(expected), glm::normalize(decoded[i]));
+                    report.maxAngleError = glm::max(report.maxAngleError, glm::degrees(glm::acos(glm::clamp(cosAngle, -1.0f, 1.0f))));
+                }
+            }
+        }
+    }
+    double texels = double(size) * size * NUM_FACES * iterations;
+    report.rmsError = float(std::sqrt(squaredError / (double(size) * size * NUM_FACES)));
+    report.encodeMTexelsPerSecond = texels / encodeSeconds * 1.0E-6;
+    report.decodeMTexelsPerSecond = texels / decodeSeconds * 1.0E-6;
+    return report;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "CubeFace.hpp"
+#include "glm/glm.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace flow
+{
+    class LayerStack;
+
+    /*
+    runtime flow formats. rows are tightly packed, texels are
+        RG8         2 x unorm8,  v * 0.5 + 0.5 of the face space flow
+        RG16        2 x unorm16, same mapping
+        OCTAHEDRAL  4 x unorm8, rg = octahedral world space direction, b = magnitude, a = 255
+    */
+    enum class Encoding {
+        RG8,
+        RG16,
+        OCTAHEDRAL
+    };
+    constexpr Encoding ENCODINGS[] = { Encoding::RG8, Encoding::RG16, Encoding::OCTAHEDRAL };
+
+    struct EncodeOptions {
+        float maxMagnitude = 1;     // flow length mapped to the edge of the range
+        bool dither = false;        // blue-noise dithering, RG8 only
+    };
+
+    char const *encodingToString(Encoding encoding) noexcept;
+    size_t getTexelSize(Encoding encoding) noexcept;
+
+    // size x size texels of one cube face
+    std::vector<uint8_t> encodeFace(unsigned face, glm::vec2 const *src, unsigned size, Encoding encoding, EncodeOptions const &options = {});
+    void decodeFace(unsigned face, uint8_t const *src, unsigned size, Encoding encoding, glm::vec2 *dst, EncodeOptions const &options = {});
+
+    // 64 x 64 void-and-cluster ranks in [0, 1), generated once
+    float const *getBlueNoise() noexcept;
+    constexpr unsigned BLUE_NOISE_SIZE = 64;
+
+    struct RoundTripReport {
+        Encoding encoding;
+        float maxError = 0;         // flow units
+        float rmsError = 0;
+        float maxAngleError = 0;    // degrees, over texels longer than 1% of maxMagnitude
+        double encodeMTexelsPerSecond = 0;
+        double decodeMTexelsPerSecond = 0;
+    };
+    // encode and decode the current composite, measure error and throughput
+    RoundTripReport benchmarkRoundTrip(LayerStack const &layers, Encoding encoding, EncodeOptions const &options = {}, unsigned iterations = 8);
+} // namespace flow
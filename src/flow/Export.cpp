@@ -0,0 +1,135 @@
+#include "Export.hpp"
+#include "LayerStack.hpp"
+#include "export/Ktx2.hpp"
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    unsigned getImageChannels(flow::Encoding encoding)
+    {
+        return encoding == flow::Encoding::OCTAHEDRAL ? 4 : 3;
+    }
+
+    // bilinear within the face, clamped to its edges
+    void resampleFace(std::vector<glm::vec2> const &src, unsigned srcSize, glm::vec2 *dst, unsigned dstSize)
+    {
+        for(unsigned y = 0; y < dstSize; ++y) {
+            for(unsigned x = 0; x < dstSize; ++x) {
+                glm::vec2 position = (glm::vec2{x, y} + 0.5f) * float(srcSize) / float(dstSize) - 0.5f;
+                position = glm::clamp(position, glm::vec2{0}, glm::vec2{float(srcSize - 1)});
+                glm::uvec2 p0{position};
+                glm::uvec2 p1 = glm::min(p0 + 1u, glm::uvec2{srcSize - 1});
+                glm::vec2 t = position - glm::vec2{p0};
+                glm::vec2 top = glm::mix(src[p0.y * srcSize + p0.x], src[p0.y * srcSize + p1.x], t.x);
+                glm::vec2 bottom = glm::mix(src[p1.y * srcSize + p0.x], src[p1.y * srcSize + p1.x], t.x);
+                dst[size_t(y) * dstSize + x] = glm::mix(top, bottom, t.y);
+            }
+        }
+    }
+} // namespace
+
+flow::ExportReport flow::exportBC5(LayerStack const &layers, std::filesystem::path const &path, bc::Quality quality, EncodeOptions const &options)
+{
+    auto start = std::chrono::steady_clock::now();
+    ExportReport report{};
+    unsigned size = layers.getFaceSize();
+    size_t numTexels = size_t(size) * size;
+
+    ktx2::Texture texture{};
+    texture.format = ktx2::Format::BC5_UNORM_BLOCK;
+    texture.width = size;
+    texture.height = size;
+    texture.faceCount = NUM_FACES;
+    std::vector<uint8_t> &level = texture.levels.emplace_back();
+
+    std::vector<float> unorm(numTexels * 2), decoded(numTexels * 2);
+    double squaredError = 0;
+    for(unsigned face = 0; face < NUM_FACES; ++face) {
+        std::vector<glm::vec2> const &composite = layers.getComposite(face);
+        for(size_t i = 0; i < numTexels; ++i) {
+            glm::vec2 value = glm::clamp(composite[i] / options.maxMagnitude, -1.0f, 1.0f) * 0.5f + 0.5f;
+            unorm[2 * i + 0] = value.x;
+            unorm[2 * i + 1] = value.y;
+        }
+        std::vector<uint8_t> blocks = bc::encodeBC5(unorm.data(), size, size, quality);
+        level.insert(level.end(), blocks.begin(), blocks.end());
+
+        bc::decodeBC5(blocks.data(), size, size, decoded.data());
+        for(size_t i = 0; i < numTexels; ++i) {
+            glm::vec2 difference = glm::vec2{decoded[2 * i] - unorm[2 * i], decoded[2 * i + 1] - unorm[2 * i + 1]} * 2.0f * options.maxMagnitude;
+            float error = glm::length(difference);
+            report.maxError = glm::max(report.maxError, error);
+            squaredError += double(error) * error;
+        }
+    }
+    ktx2::write(path, texture);
+
+    report.bytes = level.size();
+    report.rmsError = float(std::sqrt(squaredError / double(numTexels * NUM_FACES)));
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void flow::exportImage(LayerStack const &layers, std::filesystem::path const &path, Encoding encoding, EncodeOptions const &options)
+{
+    if(encoding == Encoding::RG16) throw std::runtime_error{"RG16 flow can not be written as png"};
+    unsigned size = layers.getFaceSize();
+    unsigned channels = getImageChannels(encoding);
+    size_t texelSize = getTexelSize(encoding);
+    size_t stride = size_t(size) * NUM_FACES * channels;
+    std::vector<uint8_t> image(stride * size, 0);
+
+    for(unsigned face = 0; face < NUM_FACES; ++face) {
+        std::vector<uint8_t> encoded = encodeFace(face, layers.getComposite(face).data(), size, encoding, options);
+        for(unsigned y = 0; y < size; ++y) {
+            for(unsigned x = 0; x < size; ++x) {
+                uint8_t *dst = image.data() + y * stride + (size_t(face) * size + x) * channels;
+                std::memcpy(dst, encoded.data() + (size_t(y) * size + x) * texelSize, texelSize);
+            }
+        }
+    }
+    if(!stbi_write_png(path.string().c_str(), int(size * NUM_FACES), int(size), int(channels), image.data(), int(stride)))
+        throw std::runtime_error{"failed to write \"" + path.string() + "\""};
+}
+
+void flow::importImage(LayerStack &layers, unsigned index, std::filesystem::path const &path, Encoding encoding, EncodeOptions const &options)
+{
+    unsigned channels = getImageChannels(encoding);
+    int width = 0, height = 0, numChannels = 0;
+    stbi_set_flip_vertically_on_load(false);
+    void *image = encoding == Encoding::RG16
+        ? static_cast<void *>(stbi_load_16(path.string().c_str(), &width, &height, &numChannels, int(channels)))
+        : static_cast<void *>(stbi_load(path.string().c_str(), &width, &height, &numChannels, int(channels)));
+    if(!image) throw std::runtime_error{"failed to load an image: " + path.string()};
+    if(height <= 0 || width != height * int(NUM_FACES)) {
+        stbi_image_free(image);
+        throw std::runtime_error{"\"" + path.string() + "\" is not a 6 face strip"};
+    }
+
+    unsigned srcSize = unsigned(height);
+    size_t texelSize = getTexelSize(encoding);
+    size_t componentSize = texelSize / (encoding == Encoding::OCTAHEDRAL ? 4 : 2);
+    std::vector<uint8_t> encoded(size_t(srcSize) * srcSize * texelSize);
+    std::vector<glm::vec2> decoded(size_t(srcSize) * srcSize), resampled(size_t(layers.getFaceSize()) * layers.getFaceSize());
+    for(unsigned face = 0; face < NUM_FACES; ++face) {
+        for(unsigned y = 0; y < srcSize; ++y) {
+            for(unsigned x = 0; x < srcSize; ++x) {
+                uint8_t const *src = static_cast<uint8_t const *>(image) + ((size_t(y) * width + size_t(face) * srcSize + x) * channels) * componentSize;
+                std::memcpy(encoded.data() + (size_t(y) * srcSize + x) * texelSize, src, texelSize);
+            }
+        }
+        decodeFace(face, encoded.data(), srcSize, encoding, decoded.data(), options);
+        if(srcSize == layers.getFaceSize()) {
+            layers.setFace(index, face, decoded.data());
+        } else {
+            resampleFace(decoded, srcSize, resampled.data(), layers.getFaceSize());
+            layers.setFace(index, face, resampled.data());
+        }
+    }
+    stbi_image_free(image);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Encoding.hpp"
+#include "export/BlockCompression.hpp"
+#include <filesystem>
+
+namespace flow
+{
+    class LayerStack;
+
+    struct ExportReport {
+        double seconds = 0;
+        size_t bytes = 0;       // compressed payload, all faces
+        float maxError = 0;     // flow units, after decompression
+        float rmsError = 0;
+    };
+
+    // composite -> BC5_UNORM KTX2 cubemap, rg = flow / maxMagnitude * 0.5 + 0.5 like RG8. throws std::runtime_error
+    ExportReport exportBC5(LayerStack const &layers, std::filesystem::path const &path, bc::Quality quality = bc::Quality::NORMAL, EncodeOptions const &options = {});
+
+    /*
+    png strips: the six faces side by side in +X, -X, +Y, -Y, +Z, -Z order, 6 * size x size texels.
+    RG8 is stored as rgb with b = 0, OCTAHEDRAL as rgba. RG16 can only be imported, from 16 bit pngs.
+    */
+    // composite -> png strip. throws std::runtime_error
+    void exportImage(LayerStack const &layers, std::filesystem::path const &path, Encoding encoding = Encoding::RG8, EncodeOptions const &options = {});
+    // png strip -> every face of one layer, bilinearly resampled when the strip has a different face size. throws std::runtime_error
+    void importImage(LayerStack &layers, unsigned index, std::filesystem::path const &path, Encoding encoding = Encoding::RG8, EncodeOptions const &options = {});
+} // namespace flow
@@ -0,0 +1,166 @@
+#include "Journal.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace
+{
+    constexpr char const *HEADER = "flowjournal 1";
+
+    template <typename... Args_t>
+    std::string format(Args_t const &...args)
+    {
+        std::ostringstream stream;
+        stream << std::setprecision(9);  // floats round trip exactly
+        ((stream << args << ' '), ...);
+        std::string line = stream.str();
+        line.pop_back();
+        return line;
+    }
+
+    flow::BlendMode parseBlendMode(std::string const &name)
+    {
+        for(flow::BlendMode mode : { flow::BlendMode::ADD, flow::BlendMode::OVERRIDE, flow::BlendMode::ROTATE }) {
+            if(name == flow::blendModeToString(mode)) return mode;
+        }
+        throw std::runtime_error{"unknown blend mode \"" + name + "\""};
+    }
+    flow::Pattern parsePattern(std::string const &name)
+    {
+        for(flow::Pattern pattern : { flow::Pattern::ZERO, flow::Pattern::SWIRL }) {
+            if(name == flow::patternToString(pattern)) return pattern;
+        }
+        throw std::runtime_error{"unknown pattern \"" + name + "\""};
+    }
+} // namespace
+
+char const *flow::patternToString(Pattern pattern) noexcept
+{
+    switch (pattern)
+    {
+    case Pattern::ZERO:  return "zero";
+    case Pattern::SWIRL: return "swirl";
+    default:             return "unknown";
+    }
+}
+glm::vec2 flow::evaluatePattern(Pattern pattern, unsigned face, glm::vec2 uv)
+{
+    switch (pattern)
+    {
+    case Pattern::SWIRL: return tangentToFace(face, glm::cross(glm::vec3{0, 1, 0}, faceToDirection(face, uv)));
+    default:             return glm::vec2{0};
+    }
+}
+
+unsigned flow::Journal::record(LayerStack &layers, std::string const &line)
+{
+    unsigned result = apply(layers, line);
+    m_lines.push_back(line);
+    return result;
+}
+unsigned flow::Journal::apply(LayerStack &layers, std::string const &line)
+{
+    std::istringstream stream{line};
+    std::string command;
+    stream >> command;
+    auto readLayer = [&]() {
+        unsigned index = 0;
+        if(!(stream >> index) || index >= layers.getNumLayers()) throw std::runtime_error{"bad layer index"};
+        return index;
+    };
+    auto expect = [&](bool ok) {
+        if(!ok) throw std::runtime_error{"malformed arguments"};
+    };
+
+    if(command == "add") {
+        std::string blendMode, name;
+        expect(bool(stream >> blendMode));
+        std::getline(stream >> std::ws, name);
+        return layers.addLayer(name, parseBlendMode(blendMode));
+    } else if(command == "remove") {
+        layers.removeLayer(readLayer());
+    } else if(command == "move") {
+        unsigned from = readLayer(), to = readLayer();
+        layers.moveLayer(from, to);
+    } else if(command == "blend") {
+        unsigned index = readLayer();
+        std::string blendMode;
+        expect(bool(stream >> blendMode));
+        layers.setBlendMode(index, parseBlendMode(blendMode));
+    } else if(command == "opacity") {
+        unsigned index = readLayer();
+        float opacity = 0;
+        expect(bool(stream >> opacity));
+        layers.setOpacity(index, opacity);
+    } else if(command == "enabled") {
+        unsigned index = readLayer();
+        int enabled = 0;
+        expect(bool(stream >> enabled));
+        layers.setEnabled(index, enabled != 0);
+    } else if(command == "fill") {
+        unsigned index = readLayer();
+        std::string pattern;
+        expect(bool(stream >> pattern));
+        Pattern parsed = parsePattern(pattern);
+        layers.fill(index, [parsed](unsigned face, glm::vec2 uv) { return evaluatePattern(parsed, face, uv); });
+    } else if(command == "paint") {
+        unsigned index = readLayer();
+        std::string target;
+        Brush brush{};
+        expect(bool(stream >> target
+            >> brush.direction.x >> brush.direction.y >> brush.direction.z >> brush.radius >> brush.strength
+            >> brush.tangent.x >> brush.tangent.y >> brush.tangent.z >> brush.scalar));
+        if(target != "value" && target != "mask") throw std::runtime_error{"unknown brush target \"" + target + "\""};
+        brush.target = target == "mask" ? Brush::Target::MASK : Brush::Target::VALUE;
+        layers.paint(index, brush);
+    } else {
+        throw std::runtime_error{"unknown command \"" + command + "\""};
+    }
+    return 0;
+}
+
+unsigned flow::Journal::addLayer(LayerStack &layers, std::string const &name, BlendMode blendMode) { return record(layers, format("add", blendModeToString(blendMode), name)); }
+void flow::Journal::removeLayer(LayerStack &layers, unsigned index) { record(layers, format("remove", index)); }
+void flow::Journal::moveLayer(LayerStack &layers, unsigned from, unsigned to) { record(layers, format("move", from, to)); }
+void flow::Journal::setBlendMode(LayerStack &layers, unsigned index, BlendMode blendMode) { record(layers, format("blend", index, blendModeToString(blendMode))); }
+void flow::Journal::setOpacity(LayerStack &layers, unsigned index, float opacity) { record(layers, format("opacity", index, opacity)); }
+void flow::Journal::setEnabled(LayerStack &layers, unsigned index, bool enabled) { record(layers, format("enabled", index, int(enabled))); }
+void flow::Journal::fill(LayerStack &layers, unsigned index, Pattern pattern) { record(layers, format("fill", index, patternToString(pattern))); }
+void flow::Journal::paint(LayerStack &layers, unsigned index, Brush const &brush)
+{
+    record(layers, format("paint", index, brush.target == Brush::Target::MASK ? "mask" : "value",
+        brush.direction.x, brush.direction.y, brush.direction.z, brush.radius, brush.strength,
+        brush.tangent.x, brush.tangent.y, brush.tangent.z, brush.scalar));
+}
+
+void flow::Journal::save(std::filesystem::path const &path) const
+{
+    std::ofstream file{path};
+    file << HEADER << '\n';
+    for(std::string const &line : m_lines) file << line << '\n';
+    if(!file) throw std::runtime_error{"failed to write \"" + path.string() + "\""};
+}
+flow::Journal flow::Journal::load(std::filesystem::path const &path)
+{
+    std::ifstream file{path};
+    if(!file) throw std::runtime_error{"failed to open \"" + path.string() + "\""};
+    std::string line;
+    if(!std::getline(file, line) || line != HEADER) throw std::runtime_error{"\"" + path.string() + "\" is not a flow journal"};
+    Journal journal{};
+    while(std::getline(file, line)) {
+        if(line.empty() || line[0] == '#') continue;
+        journal.m_lines.push_back(line);
+    }
+    return journal;
+}
+void flow::Journal::replay(LayerStack &layers) const
+{
+    for(size_t i = 0; i < m_lines.size(); ++i) {
+        try {
+            apply(layers, m_lines[i]);
+        } catch(std::exception const &e) {
+            throw std::runtime_error{"journal entry " + std::to_string(i + 1) + " \"" + m_lines[i] + "\": " + e.what()};
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "LayerStack.hpp"
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace flow
+{
+    // procedural fills that can be named in a journal
+    enum class Pattern {
+        ZERO,
+        SWIRL       // around the y axis
+    };
+    char const *patternToString(Pattern pattern) noexcept;
+    glm::vec2 evaluatePattern(Pattern pattern, unsigned face, glm::vec2 uv);
+
+    /*
+    text log of layer stack edits, one per line after a "flowjournal 1" header:
+        add <blend mode> <name>
+        remove <layer>
+        move <from> <to>
+        blend <layer> <blend mode>
+        opacity <layer> <opacity>
+        enabled <layer> <0 | 1>
+        fill <layer> <pattern>
+        paint <layer> <value | mask> <direction xyz> <radius> <strength> <tangent xyz> <scalar>
+    edits made through the journal are applied to the stack and recorded. brushes are in directions and radians,
+    so a journal replays at any face size.
+    */
+    class Journal
+    {
+    private:
+        std::vector<std::string> m_lines;
+
+        unsigned record(LayerStack &layers, std::string const &line);
+        static unsigned apply(LayerStack &layers, std::string const &line);
+    public:
+        unsigned addLayer(LayerStack &layers, std::string const &name, BlendMode blendMode = BlendMode::OVERRIDE);
+        void removeLayer(LayerStack &layers, unsigned index);
+        void moveLayer(LayerStack &layers, unsigned from, unsigned to);
+        void setBlendMode(LayerStack &layers, unsigned index, BlendMode blendMode);
+        void setOpacity(LayerStack &layers, unsigned index, float opacity);
+        void setEnabled(LayerStack &layers, unsigned index, bool enabled);
+        void fill(LayerStack &layers, unsigned index, Pattern pattern);
+        void paint(LayerStack &layers, unsigned index, Brush const &brush);
+
+        inline void clear() noexcept { m_lines.clear(); }
+        inline size_t getNumEntries() const noexcept { return m_lines.size(); }
+
+        // throw std::runtime_error
+        void save(std::filesystem::path const &path) const;
+        static Journal load(std::filesystem::path const &path);
+        // apply every entry to layers, normally a fresh stack
+        void replay(LayerStack &layers) const;
+    };
+} // namespace flow
@@ -0,0 +1,258 @@
+#include "LayerStack.hpp"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLOW_SSE2 1
+#endif
+
+char const *flow::blendModeToString(BlendMode mode) noexcept
+{
+    switch (mode)
+    {
+    case BlendMode::ADD:      return "add";
+    case BlendMode::OVERRIDE: return "override";
+    case BlendMode::ROTATE:   return "rotate";
+    default:                  return "unknown";
+    }
+}
+
+void flow::blendRow(glm::vec2 *dst, glm::vec2 const *src, float const *mask, unsigned count, BlendMode mode, float opacity) noexcept
+{
+    static_assert(sizeof(glm::vec2) == 2 * sizeof(float));
+    float *d = &dst[0].x;
+    float const *s = &src[0].x;
+    unsigned i = 0;
+
+#ifdef FLOW_SSE2
+    // two texels per iteration, weights laid out as (w0, w0, w1, w1)
+    __m128 const opacity4 = _mm_set1_ps(opacity);
+    for(; i + 2 <= count; i += 2) {
+        __m128 weight = opacity4;
+        if(mask) {
+            __m128 m = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<double const *>(mask + i)));
+            weight = _mm_mul_ps(weight, _mm_unpacklo_ps(m, m));
+        }
+        __m128 a = _mm_loadu_ps(d + 2 * i);
+        __m128 b = _mm_loadu_ps(s + 2 * i);
+        switch (mode)
+        {
+        case BlendMode::ADD:
+            a = _mm_add_ps(a, _mm_mul_ps(b, weight));
+            break;
+        case BlendMode::OVERRIDE:
+            a = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), weight));
+            break;
+        case BlendMode::ROTATE: {
+            alignas(16) float w[4], cs[4], sn[4];
+            _mm_store_ps(w, _mm_mul_ps(b, weight));
+            cs[0] = cs[1] = std::cos(w[0]); sn[0] = -(sn[1] = std::sin(w[0]));
+            cs[2] = cs[3] = std::cos(w[2]); sn[2] = -(sn[3] = std::sin(w[2]));
+            __m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+            a = _mm_add_ps(_mm_mul_ps(a, _mm_load_ps(cs)), _mm_mul_ps(swapped, _mm_load_ps(sn)));
+            break;
+        }
+        }
+        _mm_storeu_ps(d + 2 * i, a);
+    }
+#endif
+
+    for(; i < count; ++i) {
+        float weight = opacity * (mask ? mask[i] : 1.0f);
+        switch (mode)
+        {
+        case BlendMode::ADD:
+            dst[i] += src[i] * weight;
+            break;
+        case BlendMode::OVERRIDE:
+            dst[i] += (src[i] - dst[i]) * weight;
+            break;
+        case BlendMode::ROTATE: {
+            float angle = src[i].x * weight;
+            float c = std::cos(angle), sn = std::sin(angle);
+            dst[i] = glm::vec2{c * dst[i].x - sn * dst[i].y, sn * dst[i].x + c * dst[i].y};
+            break;
+        }
+        }
+    }
+}
+
+flow::LayerStack::LayerStack(unsigned faceSize) : m_faceSize(faceSize), m_tilesPerSide(faceSize / TILE_SIZE)
+{
+    if(faceSize == 0 || faceSize % TILE_SIZE != 0)
+        throw std::invalid_argument{"flow face size has to be a multiple of the tile size"};
+    for(auto &face : m_composite) {
+        face.assign(size_t(m_faceSize) * m_faceSize, glm::vec2{0});
+    }
+    m_dirty.assign(getNumTiles(), 1);
+    m_pending.assign(getNumTiles(), 0);
+}
+
+unsigned flow::LayerStack::addLayer(std::string const &name, BlendMode blendMode)
+{
+    Layer &layer = m_layers.emplace_back();
+    layer.name = name;
+    layer.blendMode = blendMode;
+    for(auto &face : layer.values) {
+        face.assign(size_t(m_faceSize) * m_faceSize, glm::vec2{0});
+    }
+    layer.coverage.assign(getNumTiles(), 0);
+    return getNumLayers() - 1;
+}
+void flow::LayerStack::removeLayer(unsigned index)
+{
+    markCoverageDirty(m_layers.at(index));
+    m_layers.erase(m_layers.begin() + index);
+}
+void flow::LayerStack::moveLayer(unsigned from, unsigned to)
+{
+    assert(from < m_layers.size() && to < m_layers.size());
+    markCoverageDirty(m_layers[from]);
+    Layer layer = std::move(m_layers[from]);
+    m_layers.erase(m_layers.begin() + from);
+    m_layers.insert(m_layers.begin() + to, std::move(layer));
+}
+
+void flow::LayerStack::setBlendMode(unsigned index, BlendMode blendMode)
+{
+    Layer &layer = m_layers.at(index);
+    if(layer.blendMode == blendMode) return;
+    layer.blendMode = blendMode;
+    markCoverageDirty(layer);
+}
+void flow::LayerStack::setOpacity(unsigned index, float opacity)
+{
+    Layer &layer = m_layers.at(index);
+    if(layer.opacity == opacity) return;
+    layer.opacity = opacity;
+    markCoverageDirty(layer);
+}
+void flow::LayerStack::setEnabled(unsigned index, bool enabled)
+{
+    Layer &layer = m_layers.at(index);
+    if(layer.enabled == enabled) return;
+    layer.enabled = enabled;
+    markCoverageDirty(layer);
+}
+
+void flow::LayerStack::fill(unsigned index, std::function<glm::vec2(unsigned face, glm::vec2 uv)> const &generator)
+{
+    Layer &layer = m_layers.at(index);
+    for(unsigned face = 0; face < NUM_FACES; ++face) {
+        for(unsigned y = 0; y < m_faceSize; ++y) {
+            for(unsigned x = 0; x < m_faceSize; ++x) {
+                glm::vec2 uv = (glm::vec2{x, y} + 0.5f) / float(m_faceSize);
+                layer.values[face][size_t(y) * m_faceSize + x] = generator(face, uv);
+            }
+        }
+    }
+    std::fill(layer.coverage.begin(), layer.coverage.end(), 1);
+    markCoverageDirty(layer);
+}
+
+void flow::LayerStack::setFace(unsigned index, unsigned face, glm::vec2 const *values)
+{
+    Layer &layer = m_layers.at(index);
+    std::copy(values, values + layer.values.at(face).size(), layer.values[face].begin());
+    unsigned first = getTileIndex(face, 0, 0);
+    std::fill(layer.coverage.begin() + first, layer.coverage.begin() + first + m_tilesPerSide * m_tilesPerSide, 1);
+    std::fill(m_dirty.begin() + first, m_dirty.begin() + first + m_tilesPerSide * m_tilesPerSide, 1);
+}
+
+void flow::LayerStack::paint(unsigned index, Brush const &brush)
+{
+    Layer &layer = m_layers.at(index);
+    glm::vec3 const center = glm::normalize(brush.direction);
+    if(brush.target == Brush::Target::MASK && layer.mask[0].empty()) {
+        for(auto &face : layer.mask) {
+            face.assign(size_t(m_faceSize) * m_faceSize, 1.0f);
+        }
+    }
+
+    for(unsigned face = 0; face < NUM_FACES; ++face) {
+        for(unsigned tileY = 0; tileY < m_tilesPerSide; ++tileY) {
+            for(unsigned tileX = 0; tileX < m_tilesPerSide; ++tileX) {
+                // cull tiles by their angular extent
+                glm::vec2 uvMin = glm::vec2{tileX, tileY} / float(m_tilesPerSide);
+                glm::vec2 uvMax = glm::vec2{tileX + 1, tileY + 1} / float(m_tilesPerSide);
+                glm::vec3 tileCenter = faceToDirection(face, (uvMin + uvMax) * 0.5f);
+                float tileRadius = 0;
+                for(glm::vec2 corner : {uvMin, uvMax, glm::vec2{uvMin.x, uvMax.y}, glm::vec2{uvMax.x, uvMin.y}}) {
+                    tileRadius = glm::max(tileRadius, glm::acos(glm::clamp(glm::dot(tileCenter, faceToDirection(face, corner)), -1.0f, 1.0f)));
+                }
+                if(glm::acos(glm::clamp(glm::dot(tileCenter, center), -1.0f, 1.0f)) > brush.radius + tileRadius) continue;
+
+                bool touched = false;
+                for(unsigned y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; ++y) {
+                    for(unsigned x = tileX * TILE_SIZE; x < (tileX + 1) * TILE_SIZE; ++x) {
+                        glm::vec3 dir = faceToDirection(face, (glm::vec2{x, y} + 0.5f) / float(m_faceSize));
+                        float angle = glm::acos(glm::clamp(glm::dot(dir, center), -1.0f, 1.0f));
+                        if(angle >= brush.radius) continue;
+                        float t = angle / brush.radius;
+                        float weight = glm::clamp((1 - t * t) * (1 - t * t) * brush.strength, 0.0f, 1.0f);
+                        size_t offset = size_t(y) * m_faceSize + x;
+
+                        if(brush.target == Brush::Target::MASK) {
+                            layer.mask[face][offset] = glm::mix(layer.mask[face][offset], brush.scalar, weight);
+                        } else if(layer.blendMode == BlendMode::ROTATE) {
+                            layer.values[face][offset].x = glm::mix(layer.values[face][offset].x, brush.scalar, weight);
+                        } else {
+                            glm::vec3 tangent = brush.tangent - dir * glm::dot(brush.tangent, dir);
+                            layer.values[face][offset] = glm::mix(layer.values[face][offset], tangentToFace(face, tangent), weight);
+                        }
+                        touched = true;
+                    }
+                }
+                if(touched) {
+                    unsigned tile = getTileIndex(face, tileX, tileY);
+                    layer.coverage[tile] = 1;
+                    m_dirty[tile] = 1;
+                }
+            }
+        }
+    }
+}
+
+void flow::LayerStack::markAllDirty()
+{
+    std::fill(m_dirty.begin(), m_dirty.end(), 1);
+}
+void flow::LayerStack::markCoverageDirty(Layer const &layer)
+{
+    for(unsigned tile = 0; tile < getNumTiles(); ++tile) {
+        m_dirty[tile] |= layer.coverage[tile];
+    }
+}
+
+void flow::LayerStack::compositeTile(unsigned tile)
+{
+    unsigned face = tile / (m_tilesPerSide * m_tilesPerSide);
+    unsigned tileY = tile / m_tilesPerSide % m_tilesPerSide;
+    unsigned tileX = tile % m_tilesPerSide;
+
+    for(unsigned y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; ++y) {
+        size_t offset = size_t(y) * m_faceSize + tileX * TILE_SIZE;
+        glm::vec2 *dst = &m_composite[face][offset];
+        std::fill(dst, dst + TILE_SIZE, glm::vec2{0});
+        for(Layer const &layer : m_layers) {
+            if(!layer.enabled || !layer.coverage[tile] || layer.opacity == 0) continue;
+            blendRow(dst, &layer.values[face][offset], layer.mask[face].empty() ? nullptr : &layer.mask[face][offset], TILE_SIZE, layer.blendMode, layer.opacity);
+        }
+    }
+}
+
+unsigned flow::LayerStack::composite()
+{
+    m_lastCompositeCount = 0;
+    for(unsigned tile = 0; tile < getNumTiles(); ++tile) {
+        if(!m_dirty[tile]) continue;
+        compositeTile(tile);
+        m_dirty[tile] = 0;
+        m_pending[tile] = 1;
+        ++m_lastCompositeCount;
+    }
+    return m_lastCompositeCount;
+}
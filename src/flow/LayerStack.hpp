@@ -0,0 +1,101 @@
+#pragma once
+#include "CubeFace.hpp"
+#include "glm/glm.hpp"
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace ogl
+{
+    class Cubemap;
+} // namespace ogl
+
+namespace flow
+{
+    // compositing and uploads happen in square tiles of this many texels
+    constexpr unsigned TILE_SIZE = 32;
+
+    enum class BlendMode {
+        ADD,        // composite += value
+        OVERRIDE,   // composite = mix(composite, value, weight)
+        ROTATE      // composite rotated by value.x radians
+    };
+    char const *blendModeToString(BlendMode mode) noexcept;
+
+    struct Brush {
+        enum class Target { VALUE, MASK };
+        Target target = Target::VALUE;
+        glm::vec3 direction{0, 0, 1};   // brush center on the unit sphere
+        float radius = 0.1f;            // radians
+        float strength = 1;
+        glm::vec3 tangent{0};           // painted flow for ADD and OVERRIDE layers
+        float scalar = 0;               // painted angle for ROTATE layers, painted value for masks
+    };
+
+    struct Layer {
+        std::string name;
+        BlendMode blendMode = BlendMode::OVERRIDE;
+        float opacity = 1;
+        bool enabled = true;
+        std::array<std::vector<glm::vec2>, NUM_FACES> values;   // face space flow, ROTATE layers keep the angle in x
+        std::array<std::vector<float>, NUM_FACES> mask;         // empty until the mask is painted
+        std::vector<uint8_t> coverage;                          // tiles this layer has ever written to
+    };
+
+    /*
+    non-destructive flow layers. the composite is cached per tile,
+    edits only mark the tiles they touch, composite() rebuilds those and upload() sends them to the flow cubemap.
+    */
+    class LayerStack
+    {
+    private:
+        unsigned m_faceSize = 0;
+        unsigned m_tilesPerSide = 0;
+        std::vector<Layer> m_layers;
+        std::array<std::vector<glm::vec2>, NUM_FACES> m_composite;
+        std::vector<uint8_t> m_dirty;       // needs recompositing
+        std::vector<uint8_t> m_pending;     // recomposited, not yet uploaded
+        unsigned m_lastCompositeCount = 0;
+        unsigned m_lastUploadCount = 0;
+
+        inline unsigned getTileIndex(unsigned face, unsigned tileX, unsigned tileY) const { return (face * m_tilesPerSide + tileY) * m_tilesPerSide + tileX; }
+        void markCoverageDirty(Layer const &layer);
+        void compositeTile(unsigned tile);
+    public:
+        LayerStack() = default;
+        explicit LayerStack(unsigned faceSize);
+
+        unsigned addLayer(std::string const &name, BlendMode blendMode = BlendMode::OVERRIDE);
+        void removeLayer(unsigned index);
+        void moveLayer(unsigned from, unsigned to);
+
+        void setBlendMode(unsigned index, BlendMode blendMode);
+        void setOpacity(unsigned index, float opacity);
+        void setEnabled(unsigned index, bool enabled);
+        // fill the whole layer, generator gets the face and the texel center uv
+        void fill(unsigned index, std::function<glm::vec2(unsigned face, glm::vec2 uv)> const &generator);
+        void paint(unsigned index, Brush const &brush);
+        // replace one face of a layer, e.g. with decoded imported flow. values are getFaceSize()^2 texels
+        void setFace(unsigned index, unsigned face, glm::vec2 const *values);
+        void markAllDirty();
+
+        // recomposite dirty tiles, returns the number of tiles rebuilt
+        unsigned composite();
+        // upload tiles recomposited since the last call. cubemap needs GL_RG storage of getFaceSize()
+        unsigned upload(ogl::Cubemap const &cubemap);
+
+        inline unsigned getFaceSize() const noexcept { return m_faceSize; }
+        inline unsigned getTilesPerSide() const noexcept { return m_tilesPerSide; }
+        inline unsigned getNumTiles() const noexcept { return NUM_FACES * m_tilesPerSide * m_tilesPerSide; }
+        inline unsigned getNumLayers() const noexcept { return static_cast<unsigned>(m_layers.size()); }
+        inline Layer const &getLayer(unsigned index) const { return m_layers.at(index); }
+        inline std::vector<glm::vec2> const &getComposite(unsigned face) const { return m_composite.at(face); }
+        inline unsigned getLastCompositeCount() const noexcept { return m_lastCompositeCount; }
+        inline unsigned getLastUploadCount() const noexcept { return m_lastUploadCount; }
+    };
+
+    // dst = blend(dst, src), weight = opacity * mask (mask may be null)
+    void blendRow(glm::vec2 *dst, glm::vec2 const *src, float const *mask, unsigned count, BlendMode mode, float opacity) noexcept;
+} // namespace flow
@@ -0,0 +1,28 @@
+#include "LayerStack.hpp"
+#include "opengl/Texture.hpp"
+#include "glad/gl.h"
+
+// the only gl part of the stack, kept apart so the bake tool builds without a gl loader
+unsigned flow::LayerStack::upload(ogl::Cubemap const &cubemap)
+{
+    m_lastUploadCount = 0;
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, m_faceSize);
+    for(unsigned tile = 0; tile < getNumTiles(); ++tile) {
+        if(!m_pending[tile]) continue;
+        unsigned face = tile / (m_tilesPerSide * m_tilesPerSide);
+        unsigned tileY = tile / m_tilesPerSide % m_tilesPerSide;
+        unsigned tileX = tile % m_tilesPerSide;
+        glTextureSubImage3D(
+            cubemap.getRenderID(),
+            0,
+            tileX * TILE_SIZE, tileY * TILE_SIZE, face,
+            TILE_SIZE, TILE_SIZE, 1,
+            GL_RG, GL_FLOAT,
+            &m_composite[face][size_t(tileY * TILE_SIZE) * m_faceSize + tileX * TILE_SIZE]
+        );
+        m_pending[tile] = 0;
+        ++m_lastUploadCount;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return m_lastUploadCount;
+}
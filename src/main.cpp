@@ -27,6 +27,7 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "imgui.h"
+#include "imgui_internal.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_glfw.h"
 
@@ -35,23 +36,63 @@
 #include "ease_functions.hpp"
 
 #include "opengl/Framebuffer.hpp"
+#include "opengl/RenderTargetPool.hpp"
+#include "opengl/PostProcess.hpp"
 #include "opengl/Texture.hpp"
 #include "opengl/IndexBuffer.hpp"
 #include "opengl/VertexBuffer.hpp"
 #include "opengl/Shader.hpp"
+#include "opengl/ShaderReloader.hpp"
+#include "opengl/StateCache.hpp"
+#include "opengl/StreamBuffer.hpp"
+
+#include "flow/LayerStack.hpp"
+#include "flow/Journal.hpp"
+#include "flow/Encoding.hpp"
+#include "flow/Export.hpp"
+
+#include "pacing/FramePacer.hpp"
+
+#include "mesh/Optimize.hpp"
+#include "mesh/Pack.hpp"
+#include "mesh/Cache.hpp"
+#include "mesh/Glb.hpp"
+#include "mesh/ObjReader.hpp"
 
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <iostream>
 #include <stdexcept>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
 
 struct Mesh
 {
     ogl::VertexBuffer vbo;
+    ogl::IndexBuffer ibo;
     ogl::VertexArray vao;
-    unsigned count = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    unsigned count = 0;     // indices
+    // undoes the position quantization, see mesh/Pack.hpp
+    glm::vec3 positionScale{1};
+    glm::vec3 positionOffset{0};
+};
+// the Camera uniform block, std140. written to the stream buffer once per redraw and bound for every program
+struct CameraUniforms
+{
+    glm::mat4 viewMat;
+    glm::mat4 projectionMat;
+    glm::mat4 viewProjMat;
+    glm::vec4 cameraPos;
+    glm::vec2 viewportSize;
+    float time;
+    float deltatime;
 };
+static_assert(sizeof(CameraUniforms) == 3 * 64 + 16 + 16, "CameraUniforms has to match the std140 layout");
 template <typename T>
 struct VelocityVariable
 {
@@ -61,12 +102,18 @@ struct VelocityVariable
     T falloff = T{1};
     glm::vec2 edges{0.0f, 10.0f};
 
-    inline void update(float deltatime)
+    float restSpeed = 1.0E-3f;  // below this the velocity snaps to zero, the ease curve alone never gets there
+
+    // returns true when the value changed
+    inline bool update(float deltatime)
     {
+        T prevValue = value;
         value += velocity * deltatime;
         T x = glm::clamp((glm::abs(velocity) - T{edges.x}) / (T{edges.y} - T{edges.x}), T{0}, T{1});
         T curve = easeFunc(x);
         velocity -= velocity * curve * deltatime * falloff;
+        if(glm::dot(velocity, velocity) < restSpeed * restSpeed) velocity = T{0};
+        return value != prevValue;
     }
 };
 struct Data
@@ -80,19 +127,75 @@ struct Data
         .value = 3
     };
     float sensitivity = 500;
+
+    pacing::Settings framePacing{};
+    ogl::PostSettings post{};
+    // the viewport is only rendered when something it shows changed, otherwise the last display texture is reused
+    bool redrawRequested = true;    // for changes nothing else tracks, e.g. shader reloads
+    bool continuousRedraw = false;
+    unsigned activeFrames = 0;      // frames left to poll before blocking on events again
+    std::vector<ogl::PostBenchmark> postBenchmarks;
+    bool runPostBenchmark = false;
+
+    unsigned activeLayer = 0;
+    flow::Journal journal;
+    char journalPath[256] = "flow.flowjournal";
+    flow::Brush brush{};
+    std::optional<glm::vec3> prevBrushDir;
+
+    flow::EncodeOptions encodeOptions{};
+    std::vector<flow::RoundTripReport> roundTripReports;
+    bc::Quality exportQuality = bc::Quality::NORMAL;
+    char exportPath[256] = "flow.ktx2";
+    std::optional<flow::ExportReport> exportReport;
+
+    // render target reallocations, counted over one second
+    unsigned prevReallocations = 0;
+    double reallocationsSince = 0;
+    float reallocationsPerSecond = 0;
+    unsigned viewportRedraws = 0;
+    float viewportRedrawsPerSecond = 0;
 };
 
 int main(int argc, char **argv);
 
 constexpr unsigned NUM_SAMPLES = 4;
+constexpr unsigned CAMERA_UBO_BINDING = 0;
+constexpr size_t STREAM_BUFFER_SIZE = 64 * 1024;   // per frame data, a few frames of it in flight
+// idle loop: block this long at most waiting for events, keep polling for a few frames after anything happened so imgui settles
+constexpr double IDLE_WAIT_TIMEOUT = 0.25;
+constexpr unsigned ACTIVE_FRAMES = 3;
+constexpr unsigned FLOW_FACE_SIZE = 512;
+constexpr char const *SHADER_CACHE_DIRECTORY = ".cache/shaders";
+constexpr char const *MESH_CACHE_DIRECTORY = ".cache/meshes";
+constexpr bool QUANTIZE_POSITIONS = true;  // 16 bit positions within the mesh bounds, fine for a preview
 constexpr std::string_view EDITOR_WINDOW_NAME = "editor";
+constexpr std::string_view LAYERS_WINDOW_NAME = "layers";
+constexpr std::string_view ENCODING_WINDOW_NAME = "encoding";
+constexpr std::string_view STATS_WINDOW_NAME = "stats";
+constexpr std::string_view RENDER_WINDOW_NAME = "render";
+// every post path, compared in the render window
+std::vector<ogl::PostSettings> const POST_BENCHMARK_SETTINGS = {
+    {ogl::AntiAliasing::MSAA, ogl::ResolveMode::BLIT,   ogl::PostPath::RASTER, true},
+    {ogl::AntiAliasing::MSAA, ogl::ResolveMode::BLIT,   ogl::PostPath::RASTER, false},
+    {ogl::AntiAliasing::MSAA, ogl::ResolveMode::SHADER, ogl::PostPath::RASTER, true},
+    {ogl::AntiAliasing::MSAA, ogl::ResolveMode::SHADER, ogl::PostPath::RASTER, false},
+    {ogl::AntiAliasing::MSAA, ogl::ResolveMode::BLIT,   ogl::PostPath::COMPUTE},
+    {ogl::AntiAliasing::FXAA, ogl::ResolveMode::BLIT,   ogl::PostPath::RASTER, true},
+    {ogl::AntiAliasing::FXAA, ogl::ResolveMode::BLIT,   ogl::PostPath::RASTER, false}
+};
+std::vector<glm::ivec2> const POST_BENCHMARK_SIZES = { {640, 360}, {1280, 720}, {1920, 1080}, {3840, 2160} };
 
-void resizeColorAttachment(ogl::Framebuffer &fbo, ogl::Texture &texture, glm::ivec2 size, GLenum attachment = GL_COLOR_ATTACHMENT0);
-void resizeColorAttachment(ogl::Framebuffer &fbo, ogl::TextureMS &texture, glm::ivec2 size, GLenum attachment = GL_COLOR_ATTACHMENT0);
 bool init(GLFWwindow **window);
 Mesh load(std::string_view path);
-void processInput(Data &data);
+bool processInput(Data &data);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+std::optional<glm::vec3> pickCube(glm::mat4 const &viewProjMat, glm::vec2 ndc);
+void paintFlow(Data &data, flow::LayerStack &layers, glm::mat4 const &viewProjMat, glm::vec2 ndc);
+void drawLayersWindow(Data &data, flow::LayerStack &layers);
+void drawEncodingWindow(Data &data, flow::LayerStack const &layers);
+void drawStatsWindow(Data &data, pacing::FramePacer const &pacer, ogl::RenderTargetPool const &renderTargets, ogl::RenderTarget const &display, ogl::StreamBuffer const &streamBuffer);
+void drawRenderWindow(Data &data, ogl::PostProcess &post, ogl::ShaderReloader &shaderReloader);
 
 int main(int argc, char **argv)
 {
@@ -106,40 +209,65 @@ int main(int argc, char **argv)
     // ===================================
 
     ogl::Cubemap skybox{"res/textures/kloppenheim_06_puresky_2k.hdr"};
+    ogl::setProgramBinaryCache(SHADER_CACHE_DIRECTORY);
     ogl::ShaderProgram cubeShader{"shaders/prop"};
-    ogl::ShaderProgram displayShader{"shaders/hdrImage"};
+    ogl::UniformHandle const positionScaleUniform{"u_positionScale"};
+    ogl::UniformHandle const positionOffsetUniform{"u_positionOffset"};
     ogl::ShaderProgram skyboxShader{"shaders/skybox"};
 
     Mesh cube = load("res/models/cube.obj");
 
-    ogl::Framebuffer mainFBO;
-    ogl::Renderbuffer mainRBO{0};
-    ogl::TextureMS mainColor{GL_LINEAR, GL_CLAMP_TO_EDGE};
+    ogl::RenderTargetPool renderTargets;
+    ogl::PostProcess post{renderTargets, NUM_SAMPLES};
+    {
+        ogl::ProgramBinaryCacheStats const &stats = ogl::getProgramBinaryCacheStats();
+        LOG_INFO("shader startup took %.1f ms, %u of %u programs from the binary cache", stats.seconds * 1.0E3, stats.hits, stats.hits + stats.misses);
+    }
+    // edits under shaders/ show up without a restart, glfwPostEmptyEvent wakes an idle main loop
+    ogl::ShaderReloader shaderReloader{"shaders", glfwPostEmptyEvent};
+    shaderReloader.add(cubeShader);
+    shaderReloader.add(skyboxShader);
+    for(ogl::ShaderProgram *shader : post.getShaders()) shaderReloader.add(*shader);
 
-    ogl::Framebuffer displayFBO;
-    ogl::Renderbuffer displayRBO{0};
-    ogl::Texture displayTexture{GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE};
+    ogl::StreamBuffer streamBuffer{STREAM_BUFFER_SIZE};
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
 
     ogl::Cubemap flowCubemap{0}; // dummy argument
+    glTextureStorage2D(flowCubemap.getRenderID(), 1, GL_RG16F, FLOW_FACE_SIZE, FLOW_FACE_SIZE);
+
+    flow::LayerStack flowLayers{FLOW_FACE_SIZE};
 
     // ===================================
 
+    pacing::FramePacer pacer;
     glm::ivec2 windowSize{-1};
+    glm::ivec2 prevWindowSize{-1};
+    ogl::PostSettings prevPost{};
     Data data{};
     data.window = window;
     data.distance.falloff = 10;
+    unsigned baseLayer = data.journal.addLayer(flowLayers, "base", flow::BlendMode::OVERRIDE);
+    data.journal.fill(flowLayers, baseLayer, flow::Pattern::SWIRL);
+    data.activeLayer = data.journal.addLayer(flowLayers, "detail", flow::BlendMode::ADD);
+    data.brush.radius = glm::radians(8.0f);
+    data.brush.strength = 0.5f;
     glfwSetWindowUserPointer(data.window, &data);
     glfwSetScrollCallback(data.window, scroll_callback);
 
     // ===================================
 
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    // state the renderer changes goes through the cache, redundant calls are skipped
+    ogl::StateCache &state = ogl::getStateCache();
+    state.setEnabled(GL_BLEND, false);
+    state.setEnabled(GL_DEPTH_TEST, true);
+    state.setEnabled(GL_CULL_FACE, true);
     
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    state.cullFace(GL_BACK);
+    state.frontFace(GL_CCW);
+    state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    pacer.setSettings(data.framePacing);
 
     while (!glfwWindowShouldClose(window))
     {
@@ -149,41 +277,18 @@ int main(int argc, char **argv)
         
         ImGui::Begin(EDITOR_WINDOW_NAME.data());
         
-        auto start = std::chrono::high_resolution_clock::now();
-        glm::ivec2 prevDim = windowSize;
         windowSize = { ImGui::GetContentRegionAvail().x, ImGui::GetContentRegionAvail().y };
         windowSize = glm::max(windowSize, glm::ivec2{1}); // imgui has weird negative size when folded 
 
-        if(windowSize != prevDim)
-        { // resize drawbuffers
-            resizeColorAttachment(mainFBO, mainColor, windowSize);
-            glNamedRenderbufferStorageMultisample(mainRBO.getRenderID(), NUM_SAMPLES, GL_DEPTH24_STENCIL8, windowSize.x, windowSize.y);
-
-            resizeColorAttachment(displayFBO, displayTexture, windowSize);
-            glNamedRenderbufferStorage(displayRBO.getRenderID(), GL_DEPTH24_STENCIL8, windowSize.x, windowSize.y);
-        }
-        if(mainFBO.getRenderID() == 0)
-        {
-            mainFBO = ogl::Framebuffer{0}; // dummy argument
-            mainFBO.attach(mainColor, GL_COLOR_ATTACHMENT0);
-            mainFBO.attach(mainRBO, GL_DEPTH_STENCIL_ATTACHMENT);
-            assert(mainFBO.isComplete());
-        }
-        if(displayFBO.getRenderID() == 0)
-        {
-            displayFBO = ogl::Framebuffer{0};
-            displayFBO.attach(displayTexture, GL_COLOR_ATTACHMENT0);
-            displayFBO.attach(displayRBO, GL_DEPTH_STENCIL_ATTACHMENT);
-            assert(displayFBO.isComplete());
+        if(data.runPostBenchmark) {
+            data.runPostBenchmark = false;
+            data.postBenchmarks = ogl::benchmarkPost(post, POST_BENCHMARK_SETTINGS, POST_BENCHMARK_SIZES);
+            data.redrawRequested = true; // clobbered every target
         }
-        // why tf do i have to do it every fucking frame???
-        mainFBO.attach(mainColor, GL_COLOR_ATTACHMENT0);
-        assert(mainFBO.isComplete());
+        unsigned prevReconfigurations = renderTargets.getStats().numReconfigurations;
+        ogl::RenderTarget &sceneTarget = post.prepare(data.post, windowSize);
 
-        displayFBO.attach(displayTexture, GL_COLOR_ATTACHMENT0);
-        assert(displayFBO.isComplete());
-
-        processInput(data);
+        bool cameraMoved = processInput(data);
 
         glm::mat4 viewMat = glm::mat4{1.0f};
         viewMat = glm::translate(
@@ -204,59 +309,78 @@ int main(int argc, char **argv)
 
         // ==========================
 
-        mainFBO.bind();
-
-        glViewport(0, 0, windowSize.x, windowSize.y);
-        glDepthMask(GL_TRUE);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // ============
-        // draw a cube 
-        // ============
-
-        glDepthFunc(GL_LESS);
-        glDepthMask(GL_TRUE);
-        glEnable(GL_CULL_FACE);
-
-        cubeShader.bind();
+        flowLayers.composite();
+        bool flowChanged = flowLayers.upload(flowCubemap) > 0;
+        if(shaderReloader.update()) data.redrawRequested = true;
+
+        // a reallocated target lost its contents
+        bool redraw = data.redrawRequested || data.continuousRedraw || cameraMoved || flowChanged ||
+            windowSize != prevWindowSize || data.post != prevPost || renderTargets.getStats().numReconfigurations != prevReconfigurations;
+        data.redrawRequested = false;
+        prevWindowSize = windowSize;
+        prevPost = data.post;
+
+        if(redraw) {
+            ++data.viewportRedraws;
+            CameraUniforms camera{
+                viewMat, projMat, projMat * viewMat,
+                glm::inverse(viewMat)[3],
+                glm::vec2{windowSize},
+                float(glfwGetTime()),
+                data.deltatime
+            };
+            // a fresh range every redraw, the gpu may still read the previous one
+            ogl::StreamBuffer::Allocation cameraRange = streamBuffer.allocate(sizeof(camera), uniformAlignment);
+            assert(cameraRange.data);
+            std::memcpy(cameraRange.data, &camera, sizeof(camera));
+            glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_UBO_BINDING, streamBuffer.getRenderID(), cameraRange.offset, sizeof(camera));
+            sceneTarget.bind();
+
+            state.viewport(0, 0, windowSize.x, windowSize.y);
+            state.depthMask(true);
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+            // ============
+            // draw a cube 
+            // ============
+
+            state.depthFunc(GL_LESS);
+            state.depthMask(true);
+            state.setEnabled(GL_CULL_FACE, true);
+
+            cubeShader.bind();
+            glUniform3fv(cubeShader.getUniform(positionScaleUniform), 1, &cube.positionScale.x);
+            glUniform3fv(cubeShader.getUniform(positionOffsetUniform), 1, &cube.positionOffset.x);
+            flowCubemap.bind(1);
         
-        glUniformMatrix4fv(cubeShader.getUniform("u_viewMat"),        1, GL_FALSE, &viewMat[0][0]);
-        glUniformMatrix4fv(cubeShader.getUniform("u_projectionMat"),  1, GL_FALSE, &projMat[0][0]);
-        
-        cube.vao.bind();
-        glDrawArrays(GL_TRIANGLES, 0, cube.count);
-
-        // ==============
-        // draw a skybox 
-        // ==============
+            cube.vao.bind();
+            glDrawElements(GL_TRIANGLES, cube.count, cube.indexType, nullptr);
 
-        glDepthMask(GL_FALSE);
-        glDepthFunc(GL_LEQUAL);
-        glDisable(GL_CULL_FACE);
+            // ==============
+            // draw a skybox 
+            // ==============
 
-        skyboxShader.bind();
-        skybox.bind(0);
+            state.depthMask(false);
+            state.depthFunc(GL_LEQUAL);
+            state.setEnabled(GL_CULL_FACE, false);
 
-        glUniformMatrix4fv(skyboxShader.getUniform("u_viewMat"),        1, GL_FALSE, &viewMat[0][0]);
-        glUniformMatrix4fv(skyboxShader.getUniform("u_projectionMat"),  1, GL_FALSE, &projMat[0][0]);
+            skyboxShader.bind();
+            skybox.bind(0);
 
-        // vertices hard-coded in the shader
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 14);
+            // vertices hard-coded in the shader
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 14);
 
-        // ============================================
-        // draw to a display texture + post processing 
-        // ============================================
+            // ============================================
+            // draw to a display texture + post processing 
+            // ============================================
 
-        glDepthFunc(GL_ALWAYS);
+            state.depthFunc(GL_ALWAYS);
 
-        displayFBO.bind();
-        displayShader.bind();
-        mainColor.bind(0);
-        // vertices hard-coded in the shader
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 3);
+            post.apply(data.post, windowSize);
+        }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDepthFunc(GL_ALWAYS);
+        state.bindFramebuffer(0);
+        state.depthFunc(GL_ALWAYS);
 
         glClearColor(0, 0, 0, 0);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -266,28 +390,64 @@ int main(int argc, char **argv)
         // ==========================================
 
         ImVec2 cursorPos = ImGui::GetCursorScreenPos();
+        ogl::RenderTarget const &display = post.getDisplay(data.post);
+        glm::vec2 viewportUV = display.getViewportUV();
         ImGui::GetWindowDrawList()->AddImage(
-            reinterpret_cast<void *>(displayTexture.getRenderID()),
+            reinterpret_cast<void *>(post.getDisplayTexture(data.post)),
             cursorPos,
             ImVec2(cursorPos.x + windowSize.x, cursorPos.y + windowSize.y),
-            ImVec2(0, 1), 
-            ImVec2(1, 0)
+            ImVec2(0, viewportUV.y), 
+            ImVec2(viewportUV.x, 0)
         );
 
+        ImGui::InvisibleButton("viewport", ImVec2(windowSize.x, windowSize.y));
+        if(ImGui::IsItemActive() && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+            ImVec2 mousePos = ImGui::GetMousePos();
+            glm::vec2 ndc{
+                (mousePos.x - cursorPos.x) / windowSize.x * 2 - 1,
+                1 - (mousePos.y - cursorPos.y) / windowSize.y * 2
+            };
+            paintFlow(data, flowLayers, projMat * viewMat, ndc);
+        } else {
+            data.prevBrushDir.reset();
+        }
+
         ImGui::End(); // editor
 
+        drawLayersWindow(data, flowLayers);
+        drawEncodingWindow(data, flowLayers);
+        drawStatsWindow(data, pacer, renderTargets, display, streamBuffer);
+        drawRenderWindow(data, post, shaderReloader);
+
         // ==========================
         
         ImGui::ShowDemoWindow();
         
         // ==========================
         
-        glfwPollEvents();
+        // keep polling while a shader compiles, nothing else would wake the loop when it is done
+        if(redraw || shaderReloader.isBusy()) data.activeFrames = ACTIVE_FRAMES;
+        if(data.activeFrames > 0) {
+            --data.activeFrames;
+            glfwPollEvents();
+        } else {
+            // nothing moves, sleep until input or the timeout, so an idle editor does not spin a core and the gpu
+            ImU32 prevEventId = ImGui::GetCurrentContext()->InputEventsNextEventId;
+            glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+            pacer.markIdle();
+            // the backend turns every input callback into an imgui event. a plain timeout gets one frame to look for
+            // shader changes and goes back to sleep
+            if(ImGui::GetCurrentContext()->InputEventsNextEventId != prevEventId) data.activeFrames = ACTIVE_FRAMES;
+        }
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // restores the state it changes, the cache stays valid
+        state.endFrame();
+        streamBuffer.endFrame();
         ImGui::UpdatePlatformWindows();
         glfwSwapBuffers(window);
-        data.deltatime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count() * 1.0E-6;
+        // the whole frame, events and swap included. an idle frame reports the last active one, not its wait
+        data.deltatime = pacer.endFrame();
+        pacer.setSettings(data.framePacing);
     }
     
     glfwDestroyWindow(window);
@@ -402,30 +562,6 @@ void APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severi
             error.source.c_str(), 
             error.msg.c_str());
 }
-void resizeColorAttachment(ogl::Framebuffer &fbo, ogl::TextureMS &texture, glm::ivec2 size, GLenum attachment)
-{
-    glDeleteTextures(1, &texture.getRenderID());
-    texture.getRenderID() = 0;
-    glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &texture.getRenderID());
-    glTextureStorage2DMultisample(texture.getRenderID(), NUM_SAMPLES, GL_RGBA16F, size.x, size.y, true);
-    if(fbo.getRenderID() != 0)
-    {
-        fbo.attach(texture, GL_COLOR_ATTACHMENT0);
-        assert(fbo.isComplete());
-    }
-}
-void resizeColorAttachment(ogl::Framebuffer &fbo, ogl::Texture &texture, glm::ivec2 size, GLenum attachment)
-{
-    glDeleteTextures(1, &texture.getRenderID());
-    texture.getRenderID() = 0;
-    glCreateTextures(GL_TEXTURE_2D, 1, &texture.getRenderID());
-    glTextureStorage2D(texture.getRenderID(), 1, GL_RGBA16F, size.x, size.y);
-    if(fbo.getRenderID() != 0)
-    {
-        fbo.attach(texture, GL_COLOR_ATTACHMENT0);
-        assert(fbo.isComplete());
-    }
-}
 bool init(GLFWwindow **window)
 {
     if (!glfwInit()) {
@@ -476,11 +612,10 @@ bool init(GLFWwindow **window)
     glDebugMessageCallback(debugCallback, nullptr);
     LOG_DEBUG("running in debug mode!");
     
-    glfwSwapInterval(0);
-
     return true;
 }
-Mesh load(std::string_view path)
+// the full reader, for the obj features mesh::readObj leaves out. the shapes are concatenated in file order
+std::optional<mesh::ObjData> readObjWithTinyobj(std::string_view path)
 {
     tinyobj::ObjReaderConfig config;
     config.mtl_search_path = "./";
@@ -491,9 +626,7 @@ Mesh load(std::string_view path)
         if(!reader.Error().empty()) {
             LOG_ERROR(reader.Error().c_str());
         }
-        return Mesh{
-            .count = 0
-        };
+        return std::nullopt;
     }
 
     if(!reader.Warning().empty()) {
@@ -501,81 +634,257 @@ Mesh load(std::string_view path)
     }
 
     auto &attrib = reader.GetAttrib();
-    auto &shapes = reader.GetShapes();
-    auto &materials = reader.GetMaterials();
+    mesh::ObjData obj{attrib.vertices, attrib.normals, attrib.texcoords, {}};
+    for(auto &shape : reader.GetShapes()) {
+        // the faces are triangulated by the reader
+        for(tinyobj::index_t const &idx : shape.mesh.indices) {
+            obj.corners.push_back({idx.vertex_index, idx.normal_index, idx.texcoord_index});
+        }
+    }
+    return obj;
+}
+// the buffers for a processed mesh, the blobs are uploaded as they are
+Mesh upload(mesh::View const &view)
+{
+    Mesh mesh{};
+    mesh.count = view.indexCount;
+    mesh.indexType = view.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh.ibo = ogl::IndexBuffer{view.getIndexBytes(), view.indices, GL_STATIC_DRAW};
+    mesh.vbo = ogl::VertexBuffer{view.getVertexBytes(), view.vertices, GL_STATIC_DRAW};
+    mesh.positionScale = view.positionScale;
+    mesh.positionOffset = view.positionOffset;
+
+    // one interleaved stream, 16 bytes per vertex quantized or 20 with float positions instead of 32
+    ogl::InterleavedVertexBufferLayout layout;
+    if(view.format == mesh::VertexFormat::QUANTIZED) {
+        layout = {
+            {4, GL_UNSIGNED_SHORT, true},
+            {4, GL_INT_2_10_10_10_REV, true},
+            {2, GL_HALF_FLOAT}
+        };
+    } else {
+        layout = {
+            {3, GL_FLOAT},
+            {4, GL_INT_2_10_10_10_REV, true},
+            {2, GL_HALF_FLOAT}
+        };
+    }
+    assert(layout.getStride() == mesh::getVertexStride(view.format));
+
+    mesh.vao = ogl::VertexArray{mesh.vbo, layout};
+    mesh.vao.setIndexBuffer(mesh.ibo);
+    return mesh;
+}
+// binary gltf, the buffer views go to the gpu straight from the mapped file when gl can read them as they are
+Mesh loadGlb(std::string_view path)
+{
+    auto start = std::chrono::steady_clock::now();
+    try {
+        mesh::GlbFile file{path};
+        if(file.getPrimitives().size() > 1) {
+            LOG_WARN("\"%s\": %zu primitives, only the first one is drawn", path.data(), file.getPrimitives().size());
+        }
+        mesh::GlbFile::Primitive const &primitive = file.getPrimitives().front();
+        // the attribute locations of the prop shader, a missing one would shift the rest
+        if(!primitive.normal || !primitive.texCoord) throw std::runtime_error{"NORMAL and TEXCOORD_0 are required"};
+        mesh::GlbFile::Accessor const *attributes[] = { &primitive.position, &*primitive.normal, &*primitive.texCoord };
+        if(primitive.normal->count != primitive.position.count || primitive.texCoord->count != primitive.position.count) {
+            throw std::runtime_error{"attribute counts differ"};
+        }
+
+        // one buffer over the range the attributes live in, usually the views next to each other
+        char const *begin = attributes[0]->data;
+        char const *end = begin;
+        for(mesh::GlbFile::Accessor const *accessor : attributes) {
+            begin = std::min(begin, accessor->data);
+            end = std::max(end, accessor->data + accessor->getByteLength());
+        }
+        Mesh mesh{};
+        mesh.vbo = ogl::VertexBuffer{size_t(end - begin), begin, GL_STATIC_DRAW};
+        ogl::VertexBufferLayout layout;
+        for(mesh::GlbFile::Accessor const *accessor : attributes) {
+            layout.push({accessor->components, accessor->componentType, size_t(accessor->data - begin), accessor->normalized, accessor->stride});
+        }
+
+        // index accessors are tightly packed, only byte indices get widened
+        std::vector<uint16_t> converted{};
+        void const *indices = nullptr;
+        if(primitive.indices) {
+            mesh::GlbFile::Accessor const &accessor = *primitive.indices;
+            bool unsignedType = accessor.componentType == GL_UNSIGNED_BYTE || accessor.componentType == GL_UNSIGNED_SHORT || accessor.componentType == GL_UNSIGNED_INT;
+            if(accessor.components != 1 || !unsignedType) throw std::runtime_error{"indices are not unsigned integer scalars"};
+            if(accessor.stride != accessor.getElementSize()) throw std::runtime_error{"strided indices"};
+            // uploaded as they are, one out of range would have the gpu read past the vertex buffer
+            if(accessor.count > 0 && accessor.getMaxValue() >= primitive.position.count) throw std::runtime_error{"index out of range"};
+        }
+        if(primitive.indices && primitive.indices->componentType != GL_UNSIGNED_BYTE) {
+            mesh.indexType = primitive.indices->componentType;
+            mesh.count = primitive.indices->count;
+            indices = primitive.indices->data;
+        } else if(primitive.indices) {
+            uint8_t const *bytes = reinterpret_cast<uint8_t const *>(primitive.indices->data);
+            converted.assign(bytes, bytes + primitive.indices->count);
+        } else {
+            if(primitive.position.count > std::numeric_limits<uint16_t>::max()) throw std::runtime_error{"too many vertices without indices"};
+            converted.resize(primitive.position.count);
+            std::iota(converted.begin(), converted.end(), uint16_t(0));
+        }
+        if(!indices) {
+            mesh.indexType = GL_UNSIGNED_SHORT;
+            mesh.count = unsigned(converted.size());
+            indices = converted.data();
+        }
+        mesh.ibo = ogl::IndexBuffer{mesh.count * ogl::getSizeOfGLType(mesh.indexType), indices, GL_STATIC_DRAW};
+
+        mesh.vao = ogl::VertexArray{mesh.vbo, layout};
+        mesh.vao.setIndexBuffer(mesh.ibo);
+        LOG_INFO("loaded \"%s\" in %.2f ms: %u vertices, %u indices", path.data(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), primitive.position.count, mesh.count);
+        return mesh;
+    } catch(std::runtime_error const &e) {
+        LOG_ERROR("failed to load \"%s\"! %s", path.data(), e.what());
+        return Mesh{
+            .count = 0
+        };
+    }
+}
+Mesh load(std::string_view path)
+{
+    if(std::filesystem::path{path}.extension() == ".glb") return loadGlb(path);
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+    // the source bytes and the settings that shape the blobs make the key
+    mesh::VertexFormat format = QUANTIZE_POSITIONS ? mesh::VertexFormat::QUANTIZED : mesh::VertexFormat::PACKED;
+    mesh::MappedFile source{};
+    try {
+        source = mesh::MappedFile{path};
+    } catch(std::runtime_error const &e) {
+        LOG_ERROR("failed to load \"%s\"! %s", path.data(), e.what());
+        return Mesh{
+            .count = 0
+        };
+    }
+    uint64_t key = mesh::hashBytes(&format, sizeof(format), mesh::hashBytes(source.data(), source.size()));
+    std::filesystem::path cachePath = mesh::getCachePath(MESH_CACHE_DIRECTORY, path, key);
+    if(std::optional<mesh::CachedMesh> cached = mesh::CachedMesh::open(cachePath, key)) {
+        // straight from the mapping to the buffers
+        Mesh mesh = upload(cached->getView());
+        LOG_INFO("loaded \"%s\" from the mesh cache in %.2f ms", path.data(), elapsedMs());
+        return mesh;
+    }
+
+    // the parallel reader takes the common files, tinyobj whatever else an exporter writes
+    char const *readerName = "parallel reader";
+    double parseStart = elapsedMs();
+    std::optional<mesh::ObjData> obj = mesh::readObj(source.data(), source.size());
+    if(!obj) {
+        readerName = "tinyobj reader";
+        obj = readObjWithTinyobj(path);
+        if(!obj) {
+            return Mesh{
+                .count = 0
+            };
+        }
+    }
+    double parseMs = elapsedMs() - parseStart;
 
     std::vector<glm::vec3> positions{};
     std::vector<glm::vec3> normals  {};
     std::vector<glm::vec2> texcoords{};
-
-    Mesh mesh{};
-    mesh.count = 0;
-
-    // "unzip" the object by unpacing the indices
-    for(auto &shape : shapes) {
-        size_t index_offset = 0;
-        for(auto &face : shape.mesh.num_face_vertices) {
-            for(size_t vertex = 0; vertex < face; ++vertex) {
-                // access to vertex
-                tinyobj::index_t idx = shape.mesh.indices[index_offset + vertex];
-                assert(idx.texcoord_index >= 0);
-                assert(idx.normal_index >= 0);
-
-                positions.emplace_back(
-                    attrib.vertices[3*size_t(idx.vertex_index)+0],
-                    attrib.vertices[3*size_t(idx.vertex_index)+1],
-                    attrib.vertices[3*size_t(idx.vertex_index)+2] 
-                );
-                normals.emplace_back(
-                    attrib.normals[3*size_t(idx.normal_index)+0],
-                    attrib.normals[3*size_t(idx.normal_index)+1],
-                    attrib.normals[3*size_t(idx.normal_index)+2]
-                );
-                texcoords.emplace_back(
-                    attrib.texcoords[2*size_t(idx.texcoord_index)+0],
-                    attrib.texcoords[2*size_t(idx.texcoord_index)+1] 
-                );
-
-                ++mesh.count;
-            }
-            index_offset += face;
-            // shape.mesh.material_ids[face]; // material
+    std::vector<uint32_t> indices{};
+
+    // face corners sharing position, normal and texcoord become one vertex
+    using Corner = mesh::ObjData::Corner;
+    struct CornerHash {
+        size_t operator()(Corner const &idx) const noexcept {
+            size_t hash = size_t(idx.position) * 73856093u;
+            hash ^= size_t(idx.normal) * 19349663u;
+            hash ^= size_t(idx.texCoord) * 83492791u;
+            return hash;
+        }
+    };
+    struct CornerEqual {
+        bool operator()(Corner const &a, Corner const &b) const noexcept {
+            return a.position == b.position && a.normal == b.normal && a.texCoord == b.texCoord;
         }
+    };
+    std::unordered_map<Corner, uint32_t, CornerHash, CornerEqual> vertices{};
+    vertices.reserve(obj->positions.size() / 3);
+    indices.reserve(obj->corners.size());
+
+    for(Corner const &idx : obj->corners) {
+        assert(idx.texCoord >= 0);
+        assert(idx.normal >= 0);
+        auto [vertex, inserted] = vertices.try_emplace(idx, uint32_t(positions.size()));
+        if(inserted) {
+            positions.emplace_back(
+                obj->positions[3*size_t(idx.position)+0],
+                obj->positions[3*size_t(idx.position)+1],
+                obj->positions[3*size_t(idx.position)+2] 
+            );
+            normals.emplace_back(
+                obj->normals[3*size_t(idx.normal)+0],
+                obj->normals[3*size_t(idx.normal)+1],
+                obj->normals[3*size_t(idx.normal)+2]
+            );
+            texcoords.emplace_back(
+                obj->texCoords[2*size_t(idx.texCoord)+0],
+                obj->texCoords[2*size_t(idx.texCoord)+1] 
+            );
+        }
+        indices.push_back(vertex->second);
     }
 
-    mesh.vbo = ogl::VertexBuffer{
-        positions.size() * sizeof(decltype(positions[0])) +
-        normals.size()   * sizeof(decltype(normals[0])) +
-        texcoords.size() * sizeof(decltype(texcoords[0]))
-    };
+    float acmrBefore = mesh::computeACMR(indices, positions.size());
+    mesh::optimizeVertexCache(indices, positions.size());
+    std::vector<uint32_t> order = mesh::optimizeVertexFetch(indices, positions.size());
+    positions = mesh::remap(positions, order);
+    normals   = mesh::remap(normals,   order);
+    texcoords = mesh::remap(texcoords, order);
+
+    mesh::View view{};
+    view.format = format;
+    view.vertexCount = uint32_t(positions.size());
+    view.indexCount = uint32_t(indices.size());
+
+    // 16 bit indices where they suffice, half the index memory
+    std::vector<uint16_t> shortIndices{};
+    if(positions.size() <= std::numeric_limits<uint16_t>::max()) {
+        shortIndices.assign(indices.begin(), indices.end());
+        view.indexSize = sizeof(uint16_t);
+        view.indices = shortIndices.data();
+    } else {
+        view.indexSize = sizeof(uint32_t);
+        view.indices = indices.data();
+    }
 
-    glNamedBufferSubData(mesh.vbo.getRenderID(), 
-        0, 
-        positions.size() * sizeof(decltype(positions[0])), 
-        positions.data()
-    );
-    glNamedBufferSubData(mesh.vbo.getRenderID(), 
-        positions.size() * sizeof(decltype(positions[0])), 
-        normals.size()   * sizeof(decltype(normals[0])),
-        normals.data()
-    );
-    glNamedBufferSubData(mesh.vbo.getRenderID(), 
-        positions.size() * sizeof(decltype(positions[0])) + normals.size() * sizeof(decltype(normals[0])), 
-        texcoords.size() * sizeof(decltype(texcoords[0])),
-        texcoords.data()
-    );
-
-    ogl::VertexBufferLayout layout = {
-        {3, GL_FLOAT, 0},
-        {3, GL_FLOAT, positions.size() * sizeof(decltype(positions[0]))},
-        {2, GL_FLOAT, positions.size() * sizeof(decltype(positions[0])) + normals.size() * sizeof(decltype(normals[0]))}
-    };
-    
-    mesh.vao = ogl::VertexArray{mesh.vbo, layout};
+    std::vector<mesh::QuantizedVertex> quantizedVertices{};
+    std::vector<mesh::PackedVertex> packedVertices{};
+    if(format == mesh::VertexFormat::QUANTIZED) {
+        mesh::Bounds bounds = mesh::computeBounds(positions);
+        quantizedVertices = mesh::packQuantized(positions, normals, texcoords, bounds);
+        view.positionScale = bounds.getScale();
+        view.positionOffset = bounds.getOffset();
+        view.vertices = quantizedVertices.data();
+    } else {
+        packedVertices = mesh::pack(positions, normals, texcoords);
+        view.vertices = packedVertices.data();
+    }
 
+    try {
+        mesh::writeCache(cachePath, key, view);
+    } catch(std::runtime_error const &e) {
+        LOG_WARN("mesh cache: %s", e.what());
+    }
+    Mesh mesh = upload(view);
+    LOG_INFO("loaded \"%s\" in %.2f ms, %.2f ms in the %s: %zu corners, %zu vertices of %u bytes, ACMR %.2f -> %.2f", path.data(), elapsedMs(),
+        parseMs, readerName, indices.size(), positions.size(), mesh::getVertexStride(format), acmrBefore, mesh::computeACMR(indices, positions.size()));
     return mesh;
 }
-void processInput(Data &data)
+// returns true when the camera moved
+bool processInput(Data &data)
 {
     assert(data.window);
     ImGui::Begin(EDITOR_WINDOW_NAME.data());
@@ -592,10 +901,12 @@ void processInput(Data &data)
         data.yawPitch.velocity += deltaMouse * data.deltatime * data.sensitivity;
     }
 
-    data.yawPitch.update(data.deltatime);
+    float prevDistance = data.distance.value;
+    bool moved = data.yawPitch.update(data.deltatime);
     data.yawPitch.falloff = glm::mix(glm::vec2{1.0f}, glm::vec2{5.0f}, static_cast<float>(!cameraLocked));
     data.distance.update(data.deltatime);
     data.distance.value = glm::clamp<float>(data.distance.value, 1, 5);
+    return moved || data.distance.value != prevDistance;
 }
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
@@ -608,3 +919,300 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     }
     ImGui::End();
 }
+std::optional<glm::vec3> pickCube(glm::mat4 const &viewProjMat, glm::vec2 ndc)
+{
+    glm::mat4 inverse = glm::inverse(viewProjMat);
+    glm::vec4 nearPoint = inverse * glm::vec4{ndc, -1, 1};
+    glm::vec4 farPoint  = inverse * glm::vec4{ndc,  1, 1};
+    glm::vec3 origin = glm::vec3{nearPoint} / nearPoint.w;
+    glm::vec3 dir = glm::vec3{farPoint} / farPoint.w - origin;
+
+    // slab test against the cube model, which spans [-0.5, 0.5]
+    glm::vec3 t0 = (glm::vec3{-0.5f} - origin) / dir;
+    glm::vec3 t1 = (glm::vec3{ 0.5f} - origin) / dir;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    float tNear = glm::max(glm::max(tMin.x, tMin.y), tMin.z);
+    float tFar  = glm::min(glm::min(tMax.x, tMax.y), tMax.z);
+    if(tNear > tFar || tFar < 0) return std::nullopt;
+    return origin + dir * glm::max(tNear, 0.0f);
+}
+void paintFlow(Data &data, flow::LayerStack &layers, glm::mat4 const &viewProjMat, glm::vec2 ndc)
+{
+    if(data.activeLayer >= layers.getNumLayers()) return;
+    std::optional<glm::vec3> hit = pickCube(viewProjMat, ndc);
+    if(!hit) {
+        data.prevBrushDir.reset();
+        return;
+    }
+    glm::vec3 dir = glm::normalize(*hit);
+
+    // flow follows the stroke direction
+    bool needsTangent = data.brush.target == flow::Brush::Target::VALUE && layers.getLayer(data.activeLayer).blendMode != flow::BlendMode::ROTATE;
+    if(needsTangent) {
+        if(!data.prevBrushDir) {
+            data.prevBrushDir = dir;
+            return;
+        }
+        glm::vec3 delta = dir - *data.prevBrushDir;
+        if(glm::length(delta) < 1e-4f) return;
+        data.brush.tangent = glm::normalize(delta);
+    }
+    data.brush.direction = dir;
+    data.journal.paint(layers, data.activeLayer, data.brush);
+    data.prevBrushDir = dir;
+}
+void drawLayersWindow(Data &data, flow::LayerStack &layers)
+{
+    ImGui::Begin(LAYERS_WINDOW_NAME.data());
+
+    char const *blendModes[] = {
+        flow::blendModeToString(flow::BlendMode::ADD),
+        flow::blendModeToString(flow::BlendMode::OVERRIDE),
+        flow::blendModeToString(flow::BlendMode::ROTATE)
+    };
+    for(unsigned i = 0; i < layers.getNumLayers(); ++i) {
+        flow::Layer const &layer = layers.getLayer(i);
+        ImGui::PushID(i);
+
+        bool enabled = layer.enabled;
+        if(ImGui::Checkbox("##enabled", &enabled)) data.journal.setEnabled(layers, i, enabled);
+        ImGui::SameLine();
+        if(ImGui::Selectable(layer.name.c_str(), data.activeLayer == i)) data.activeLayer = i;
+
+        int blendMode = static_cast<int>(layer.blendMode);
+        if(ImGui::Combo("blend", &blendMode, blendModes, IM_ARRAYSIZE(blendModes))) data.journal.setBlendMode(layers, i, static_cast<flow::BlendMode>(blendMode));
+        float opacity = layer.opacity;
+        if(ImGui::SliderFloat("opacity", &opacity, 0, 1)) data.journal.setOpacity(layers, i, opacity);
+
+        ImGui::PopID();
+    }
+    if(ImGui::Button("add layer")) {
+        data.activeLayer = data.journal.addLayer(layers, "layer " + std::to_string(layers.getNumLayers()), flow::BlendMode::ADD);
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("remove layer") && layers.getNumLayers() > 1 && data.activeLayer < layers.getNumLayers()) {
+        data.journal.removeLayer(layers, data.activeLayer);
+        data.activeLayer = glm::min(data.activeLayer, layers.getNumLayers() - 1);
+    }
+
+    ImGui::SeparatorText("brush");
+    int target = static_cast<int>(data.brush.target);
+    ImGui::RadioButton("value", &target, static_cast<int>(flow::Brush::Target::VALUE));
+    ImGui::SameLine();
+    ImGui::RadioButton("mask", &target, static_cast<int>(flow::Brush::Target::MASK));
+    data.brush.target = static_cast<flow::Brush::Target>(target);
+    ImGui::SliderAngle("radius", &data.brush.radius, 0.5f, 45.0f);
+    ImGui::SliderFloat("strength", &data.brush.strength, 0, 1);
+    if(data.brush.target == flow::Brush::Target::MASK) {
+        ImGui::SliderFloat("mask value", &data.brush.scalar, 0, 1);
+    } else {
+        ImGui::SliderAngle("rotation", &data.brush.scalar, -180.0f, 180.0f);
+    }
+
+    ImGui::SeparatorText("journal");
+    ImGui::InputText("path", data.journalPath, sizeof(data.journalPath));
+    if(ImGui::Button("save")) {
+        try {
+            data.journal.save(data.journalPath);
+        } catch(std::exception const &e) {
+            LOG_ERROR("%s", e.what());
+        }
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("load")) {
+        try {
+            flow::Journal journal = flow::Journal::load(data.journalPath);
+            flow::LayerStack replayed{layers.getFaceSize()};
+            journal.replay(replayed);
+            layers = std::move(replayed);
+            data.journal = std::move(journal);
+            data.activeLayer = layers.getNumLayers() ? layers.getNumLayers() - 1 : 0;
+        } catch(std::exception const &e) {
+            LOG_ERROR("%s", e.what());
+        }
+    }
+    ImGui::SameLine();
+    ImGui::Text("%zu entries", data.journal.getNumEntries());
+
+    ImGui::SeparatorText("stats");
+    ImGui::Text("tiles recomposited: %u, uploaded: %u / %u", layers.getLastCompositeCount(), layers.getLastUploadCount(), layers.getNumTiles());
+
+    ImGui::End();
+}
+void drawEncodingWindow(Data &data, flow::LayerStack const &layers)
+{
+    ImGui::Begin(ENCODING_WINDOW_NAME.data());
+
+    ImGui::SliderFloat("max magnitude", &data.encodeOptions.maxMagnitude, 0.01f, 4.0f);
+    ImGui::Checkbox("blue-noise dither (RG8)", &data.encodeOptions.dither);
+    if(ImGui::Button("run round-trip benchmark")) {
+        data.roundTripReports.clear();
+        for(flow::Encoding encoding : flow::ENCODINGS) {
+            data.roundTripReports.push_back(flow::benchmarkRoundTrip(layers, encoding, data.encodeOptions));
+        }
+    }
+
+    if(!data.roundTripReports.empty() && ImGui::BeginTable("round trip", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("format");
+        ImGui::TableSetupColumn("max error");
+        ImGui::TableSetupColumn("rms error");
+        ImGui::TableSetupColumn("max angle");
+        ImGui::TableSetupColumn("encode MT/s");
+        ImGui::TableSetupColumn("decode MT/s");
+        ImGui::TableHeadersRow();
+        for(flow::RoundTripReport const &report : data.roundTripReports) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(flow::encodingToString(report.encoding));
+            ImGui::TableNextColumn(); ImGui::Text("%.5f", report.maxError);
+            ImGui::TableNextColumn(); ImGui::Text("%.5f", report.rmsError);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f deg", report.maxAngleError);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", report.encodeMTexelsPerSecond);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", report.decodeMTexelsPerSecond);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::SeparatorText("export");
+    ImGui::InputText("path", data.exportPath, sizeof(data.exportPath));
+    if(ImGui::BeginCombo("quality", bc::qualityToString(data.exportQuality))) {
+        for(bc::Quality quality : bc::QUALITIES) {
+            if(ImGui::Selectable(bc::qualityToString(quality), quality == data.exportQuality)) data.exportQuality = quality;
+        }
+        ImGui::EndCombo();
+    }
+    if(ImGui::Button("export BC5 cubemap (KTX2)")) {
+        try {
+            data.exportReport = flow::exportBC5(layers, data.exportPath, data.exportQuality, data.encodeOptions);
+        } catch(std::exception const &e) {
+            LOG_ERROR("%s", e.what());
+            data.exportReport.reset();
+        }
+    }
+    if(data.exportReport) {
+        ImGui::Text("%.2f s, %zu KiB, max error %.5f, rms error %.5f", data.exportReport->seconds, data.exportReport->bytes / 1024, data.exportReport->maxError, data.exportReport->rmsError);
+    }
+
+    ImGui::End();
+}
+void drawStatsWindow(Data &data, pacing::FramePacer const &pacer, ogl::RenderTargetPool const &renderTargets, ogl::RenderTarget const &display, ogl::StreamBuffer const &streamBuffer)
+{
+    ogl::RenderTargetPool::Stats const &stats = renderTargets.getStats();
+    double now = glfwGetTime();
+    if(now - data.reallocationsSince >= 1.0) {
+        data.reallocationsPerSecond = float((stats.numReconfigurations - data.prevReallocations) / (now - data.reallocationsSince));
+        data.prevReallocations = stats.numReconfigurations;
+        data.viewportRedrawsPerSecond = float(data.viewportRedraws / (now - data.reallocationsSince));
+        data.viewportRedraws = 0;
+        data.reallocationsSince = now;
+    }
+
+    ImGui::Begin(STATS_WINDOW_NAME.data());
+
+    ImGui::SeparatorText("frame pacing");
+    char const *vsyncModes[] = { pacing::vsyncToString(pacing::Vsync::OFF), pacing::vsyncToString(pacing::Vsync::ON), pacing::vsyncToString(pacing::Vsync::ADAPTIVE) };
+    int vsync = static_cast<int>(data.framePacing.vsync);
+    if(ImGui::Combo("vsync", &vsync, vsyncModes, IM_ARRAYSIZE(vsyncModes))) data.framePacing.vsync = static_cast<pacing::Vsync>(vsync);
+    ImGui::SliderFloat("target fps", &data.framePacing.targetFps, 0, 240, data.framePacing.targetFps > 0 ? "%.0f" : "unlimited");
+    ImGui::SetItemTooltip("sleeps and then spins until the frame is due. 0 for no limit");
+
+    // idle frames that block on events are not recorded
+    pacing::FrameStats frameStats = pacer.getStats();
+    std::vector<float> history = pacer.getHistory();
+    ImGui::Text("frame: %.2f ms mean over %zu frames", frameStats.mean, frameStats.count);
+    ImGui::Text("p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms", frameStats.p50, frameStats.p90, frameStats.p99, frameStats.max);
+    ImGui::PlotLines("##frame times", history.data(), int(history.size()), 0, nullptr, 0, frameStats.max * 1.0E-3f, ImVec2(0, 60));
+    ImGui::Text("sleep overshoot estimate: %.2f ms", pacer.getSleepEstimate() * 1.0E3);
+    ImGui::Text("viewport redraws: %.1f / s", data.viewportRedrawsPerSecond);
+    ogl::StateCache::Counters const &stateCalls = ogl::getStateCache().getLastFrame();
+    ImGui::Text("gl state calls: %u issued, %u elided", stateCalls.issued, stateCalls.elided);
+    ImGui::SetItemTooltip("binds and fixed function state of the last frame that drew anything, through ogl::StateCache");
+
+    ImGui::SeparatorText("render targets");
+    ImGui::Text("viewport %dx%d, allocated %dx%d", display.getViewport().x, display.getViewport().y, display.getSize().x, display.getSize().y);
+    ImGui::Text("reallocations: %.1f / s, %u total", data.reallocationsPerSecond, stats.numReconfigurations);
+    ImGui::Text("attachments created: %u, reused: %u", stats.numCreated, stats.numReused);
+    ImGui::Text("memory: %.1f MiB in use, %.1f MiB pooled", stats.usedBytes / 1048576.0, stats.freeBytes / 1048576.0);
+
+    ogl::StreamBuffer::Stats const &streamStats = streamBuffer.getStats();
+    ImGui::SeparatorText("stream buffer");
+    ImGui::Text("%zu bytes last frame, %zu peak, %zu KiB ring", streamStats.frameBytes, streamStats.peakFrameBytes, streamBuffer.getSize() / 1024);
+    ImGui::Text("fence waits: %u, %.2f ms total", streamStats.numFenceWaits, streamStats.waitSeconds * 1.0E3);
+    if(streamStats.numOverflows) ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "overflows: %u", streamStats.numOverflows);
+
+    ImGui::End();
+}
+void drawRenderWindow(Data &data, ogl::PostProcess &post, ogl::ShaderReloader &shaderReloader)
+{
+    ImGui::Begin(RENDER_WINDOW_NAME.data());
+
+    char const *antiAliasingModes[] = { "msaa", "fxaa" };
+    int antiAliasing = static_cast<int>(data.post.antiAliasing);
+    if(ImGui::Combo("anti-aliasing", &antiAliasing, antiAliasingModes, IM_ARRAYSIZE(antiAliasingModes))) data.post.antiAliasing = static_cast<ogl::AntiAliasing>(antiAliasing);
+
+    ImGui::BeginDisabled(data.post.antiAliasing != ogl::AntiAliasing::MSAA);
+    char const *postPaths[] = { "raster", "compute (fused)" };
+    int postPath = static_cast<int>(data.post.path);
+    if(ImGui::Combo("post path", &postPath, postPaths, IM_ARRAYSIZE(postPaths))) data.post.path = static_cast<ogl::PostPath>(postPath);
+    ImGui::BeginDisabled(data.post.path != ogl::PostPath::RASTER);
+    char const *resolveModes[] = { "blit", "shader (per sample tonemap)" };
+    int resolveMode = static_cast<int>(data.post.resolveMode);
+    if(ImGui::Combo("msaa resolve", &resolveMode, resolveModes, IM_ARRAYSIZE(resolveModes))) data.post.resolveMode = static_cast<ogl::ResolveMode>(resolveMode);
+    ImGui::EndDisabled();
+    ImGui::EndDisabled();
+    ImGui::BeginDisabled(data.post.antiAliasing == ogl::AntiAliasing::MSAA && data.post.path == ogl::PostPath::COMPUTE);
+    ImGui::Checkbox("srgb display target", &data.post.srgbDisplay);
+    ImGui::SetItemTooltip("8 bit display target, gamma encoded by the hardware. RGBA16F and pow() when off");
+    ImGui::EndDisabled();
+    ImGui::SliderFloat("exposure", &data.post.exposure, 0.1f, 8.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+
+    ImGui::Checkbox("redraw every frame", &data.continuousRedraw);
+    ImGui::SetItemTooltip("off: the viewport is only rendered when the camera, the flow, the size or the settings change");
+
+    ImGui::SeparatorText("shaders");
+    if(ImGui::Button("reload all")) shaderReloader.reloadAll();
+    ImGui::SameLine();
+    ImGui::TextDisabled("files under shaders/ reload on save");
+    for(ogl::ShaderReloader::Status const &status : shaderReloader.getStatus()) {
+        std::string name = status.program->getPath();
+        for(auto const &[define, value] : status.program->getDefines()) name += " " + define + "=" + value;
+        char const *state = status.compiling ? "compiling" : !status.log.empty() ? "failed, previous version in use" : "ok";
+        ImGui::BulletText("%s: %s, %u reloads", name.c_str(), state, status.reloads);
+        if(!status.log.empty()) {
+            ImGui::PushID(status.program);
+            ImGui::InputTextMultiline("##log", const_cast<char *>(status.log.c_str()), status.log.size() + 1, ImVec2(-1, ImGui::GetTextLineHeight() * 6), ImGuiInputTextFlags_ReadOnly);
+            ImGui::PopID();
+        }
+    }
+
+    // every mode at the current allocation, whether it is in use or not
+    glm::ivec2 size = post.getDisplay(data.post).getSize();
+    ImGui::SeparatorText("viewport memory");
+    ImGui::Text("at %dx%d", size.x, size.y);
+    for(ogl::PostSettings const &settings : POST_BENCHMARK_SETTINGS) {
+        bool active = std::string_view{ogl::postSettingsToString(settings)} == ogl::postSettingsToString(data.post);
+        ImGui::BulletText("%s%s: %.1f MiB", ogl::postSettingsToString(settings), active ? " (current)" : "", post.getFootprint(settings, size) / 1048576.0);
+    }
+
+    ImGui::SeparatorText("post benchmark");
+    if(ImGui::Button("run")) data.runPostBenchmark = true;
+    ImGui::SameLine();
+    ImGui::TextDisabled("stalls for a moment, ms per pass");
+    if(!data.postBenchmarks.empty() && ImGui::BeginTable("post benchmark", 1 + int(POST_BENCHMARK_SETTINGS.size()), ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("size");
+        for(ogl::PostSettings const &settings : POST_BENCHMARK_SETTINGS) ImGui::TableSetupColumn(ogl::postSettingsToString(settings));
+        ImGui::TableHeadersRow();
+        for(ogl::PostBenchmark const &result : data.postBenchmarks) {
+            if(std::string_view{ogl::postSettingsToString(result.settings)} == ogl::postSettingsToString(POST_BENCHMARK_SETTINGS[0])) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%dx%d", result.size.x, result.size.y);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", result.milliseconds);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
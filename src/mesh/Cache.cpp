@@ -0,0 +1,131 @@
+#include "Cache.hpp"
+#include "Pack.hpp"
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+
+namespace
+{
+    constexpr char MAGIC[4] = { 'F', 'C', 'M', 'C' };
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t BLOB_ALIGNMENT = 64;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t indexSize;
+        float positionScale[3];
+        float positionOffset[3];
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+    };
+
+    uint64_t alignUp(uint64_t offset) noexcept { return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1); }
+} // namespace
+
+unsigned mesh::getVertexStride(VertexFormat format) noexcept
+{
+    switch(format) {
+        case VertexFormat::PACKED:      return sizeof(PackedVertex);
+        case VertexFormat::QUANTIZED:   return sizeof(QuantizedVertex);
+    }
+    return 0;
+}
+
+uint64_t mesh::hashBytes(void const *data, size_t size, uint64_t seed) noexcept
+{
+    uint64_t hash = seed;
+    unsigned char const *bytes = static_cast<unsigned char const *>(data);
+    size_t i = 0;
+    // a word per step, sources are hashed on every load. the shift folds the high bits back down
+    for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 32;
+    }
+    for(; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::filesystem::path mesh::getCachePath(std::filesystem::path const &directory, std::filesystem::path const &source, uint64_t key)
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(key));
+    return directory / (source.stem().string() + "-" + hash + ".mesh");
+}
+
+std::optional<mesh::CachedMesh> mesh::CachedMesh::open(std::filesystem::path const &path, uint64_t key) noexcept
+{
+    CachedMesh mesh;
+    std::error_code error;
+    if(!std::filesystem::exists(path, error)) return std::nullopt;
+    try {
+        mesh.m_file = MappedFile{path};
+    } catch(std::runtime_error const &) {
+        return std::nullopt;
+    }
+    MappedFile const &file = mesh.m_file;
+    Header header;
+    if(file.size() < sizeof(header)) return std::nullopt;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.key != key) return std::nullopt;
+    if(header.format > uint32_t(VertexFormat::QUANTIZED) || (header.indexSize != 2 && header.indexSize != 4)) return std::nullopt;
+
+    View &view = mesh.m_view;
+    view.format = VertexFormat(header.format);
+    view.vertexCount = header.vertexCount;
+    view.indexCount = header.indexCount;
+    view.indexSize = header.indexSize;
+    view.positionScale = { header.positionScale[0], header.positionScale[1], header.positionScale[2] };
+    view.positionOffset = { header.positionOffset[0], header.positionOffset[1], header.positionOffset[2] };
+    // files are only renamed into place once complete, still nothing past the end is trusted
+    auto fits = [&](uint64_t offset, size_t size) { return offset % BLOB_ALIGNMENT == 0 && offset <= file.size() && size <= file.size() - offset; };
+    if(!fits(header.vertexOffset, view.getVertexBytes()) || !fits(header.indexOffset, view.getIndexBytes())) return std::nullopt;
+    view.vertices = file.data() + header.vertexOffset;
+    view.indices = file.data() + header.indexOffset;
+    return mesh;
+}
+
+void mesh::writeCache(std::filesystem::path const &path, uint64_t key, View const &view)
+{
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.key = key;
+    header.format = uint32_t(view.format);
+    header.vertexCount = view.vertexCount;
+    header.indexCount = view.indexCount;
+    header.indexSize = view.indexSize;
+    for(int i = 0; i < 3; ++i) {
+        header.positionScale[i] = view.positionScale[i];
+        header.positionOffset[i] = view.positionOffset[i];
+    }
+    header.vertexOffset = alignUp(sizeof(header));
+    header.indexOffset = alignUp(header.vertexOffset + view.getVertexBytes());
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file{temporary, std::ios::binary};
+        char const padding[BLOB_ALIGNMENT] = {};
+        file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        file.write(padding, header.vertexOffset - sizeof(header));
+        file.write(static_cast<char const *>(view.vertices), view.getVertexBytes());
+        file.write(padding, header.indexOffset - header.vertexOffset - view.getVertexBytes());
+        file.write(static_cast<char const *>(view.indices), view.getIndexBytes());
+        if(!file) throw std::runtime_error{"failed to write \"" + temporary.string() + "\""};
+    }
+    std::filesystem::rename(temporary, path, error);
+    if(error) throw std::runtime_error{"failed to write \"" + path.string() + "\": " + error.message()};
+}
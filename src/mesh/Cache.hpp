@@ -0,0 +1,54 @@
+#pragma once
+#include "MappedFile.hpp"
+#include "glm/glm.hpp"
+#include <filesystem>
+#include <optional>
+#include <cstdint>
+
+/*
+a processed mesh as one file: a header, then the vertex and index blobs exactly as they are uploaded, each aligned.
+named after the source and keyed by a hash of its bytes and the processing settings, a changed source gets a new file
+*/
+namespace mesh
+{
+    enum class VertexFormat : uint32_t {
+        PACKED,     // PackedVertex
+        QUANTIZED   // QuantizedVertex
+    };
+    unsigned getVertexStride(VertexFormat format) noexcept;
+
+    // blobs ready for upload, pointing into memory owned elsewhere
+    struct View {
+        VertexFormat format = VertexFormat::PACKED;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t indexSize = 4;             // bytes, 2 or 4
+        glm::vec3 positionScale{1};
+        glm::vec3 positionOffset{0};
+        void const *vertices = nullptr;
+        void const *indices = nullptr;
+
+        inline size_t getVertexBytes() const noexcept { return size_t(vertexCount) * getVertexStride(format); }
+        inline size_t getIndexBytes() const noexcept { return size_t(indexCount) * indexSize; }
+    };
+
+    // fnv-1a style over 64 bit words, chained through seed. not the same values as ogl::hashName
+    uint64_t hashBytes(void const *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull) noexcept;
+    std::filesystem::path getCachePath(std::filesystem::path const &directory, std::filesystem::path const &source, uint64_t key);
+
+    class CachedMesh
+    {
+    private:
+        MappedFile m_file;
+        View m_view;
+        CachedMesh() = default;
+    public:
+        // nullopt when there is no file for the key or it is damaged
+        static std::optional<CachedMesh> open(std::filesystem::path const &path, uint64_t key) noexcept;
+        // the blobs point into the mapping, valid as long as this object
+        inline View const &getView() const noexcept { return m_view; }
+    };
+
+    // written aside and renamed, throws std::runtime_error
+    void writeCache(std::filesystem::path const &path, uint64_t key, View const &view);
+} // namespace mesh
@@ -0,0 +1,133 @@
+#include "Glb.hpp"
+#include "json.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;        // "glTF"
+    constexpr uint32_t CHUNK_JSON = 0x4E4F534A;       // "JSON"
+    constexpr uint32_t CHUNK_BIN = 0x004E4942;        // "BIN\0"
+    constexpr unsigned MODE_TRIANGLES = 4;
+
+    uint32_t readUint32(char const *data) noexcept
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // 0 for an unknown type
+    size_t getComponentSize(uint32_t componentType) noexcept
+    {
+        switch(componentType) {
+            case 5120: case 5121: return 1;    // BYTE, UNSIGNED_BYTE
+            case 5122: case 5123: return 2;    // SHORT, UNSIGNED_SHORT
+            case 5125: case 5126: return 4;    // UNSIGNED_INT, FLOAT
+            default: return 0;
+        }
+    }
+
+    unsigned getComponentCount(std::string const &type)
+    {
+        if(type == "SCALAR") return 1;
+        if(type == "VEC2") return 2;
+        if(type == "VEC3") return 3;
+        if(type == "VEC4") return 4;
+        throw std::runtime_error{"accessor type " + type + " is not a vertex attribute"};
+    }
+
+    mesh::GlbFile::Accessor readAccessor(nlohmann::json const &json, size_t index, char const *bin, size_t binSize)
+    {
+        nlohmann::json const &accessor = json.at("accessors").at(index);
+        if(accessor.contains("sparse")) throw std::runtime_error{"sparse accessors are not supported"};
+        if(!accessor.contains("bufferView")) throw std::runtime_error{"accessors without a buffer view are not supported"};
+        nlohmann::json const &view = json.at("bufferViews").at(accessor.at("bufferView").get<size_t>());
+        if(view.at("buffer").get<size_t>() != 0 || !bin) throw std::runtime_error{"only the BIN chunk buffer is supported"};
+
+        mesh::GlbFile::Accessor result;
+        result.count = accessor.at("count").get<uint32_t>();
+        result.componentType = accessor.at("componentType").get<uint32_t>();
+        if(getComponentSize(result.componentType) == 0) throw std::runtime_error{"unknown accessor component type " + std::to_string(result.componentType)};
+        result.components = getComponentCount(accessor.at("type").get<std::string>());
+        result.normalized = accessor.value("normalized", false);
+        result.stride = view.value("byteStride", unsigned(result.getElementSize()));
+        if(result.stride < result.getElementSize()) throw std::runtime_error{"buffer view stride smaller than its elements"};
+
+        size_t viewOffset = view.value("byteOffset", size_t(0));
+        size_t viewLength = view.at("byteLength").get<size_t>();
+        size_t offset = accessor.value("byteOffset", size_t(0));
+        if(viewOffset > binSize || viewLength > binSize - viewOffset || offset > viewLength || result.getByteLength() > viewLength - offset) {
+            throw std::runtime_error{"accessor " + std::to_string(index) + " reaches past its buffer view"};
+        }
+        result.data = bin + viewOffset + offset;
+        return result;
+    }
+} // namespace
+
+size_t mesh::GlbFile::Accessor::getElementSize() const noexcept { return components * getComponentSize(componentType); }
+size_t mesh::GlbFile::Accessor::getByteLength() const noexcept { return count == 0 ? 0 : size_t(count - 1) * stride + getElementSize(); }
+uint32_t mesh::GlbFile::Accessor::getMaxValue() const noexcept
+{
+    if(components != 1) return 0;
+    // memcpy, a hostile file can misalign the data
+    auto scan = [this](auto zero) {
+        uint32_t max = 0;
+        for(size_t i = 0; i < count; ++i) {
+            decltype(zero) value;
+            std::memcpy(&value, data + i * stride, sizeof(value));
+            max = std::max<uint32_t>(max, value);
+        }
+        return max;
+    };
+    switch(componentType) {
+        case 5121: return scan(uint8_t{});     // UNSIGNED_BYTE
+        case 5123: return scan(uint16_t{});    // UNSIGNED_SHORT
+        case 5125: return scan(uint32_t{});    // UNSIGNED_INT
+        default: return 0;
+    }
+}
+
+mesh::GlbFile::GlbFile(std::filesystem::path const &path) :
+    m_file(path)
+{
+    char const *data = m_file.data();
+    size_t const size = m_file.size();
+    if(size < 20 || readUint32(data) != GLB_MAGIC) throw std::runtime_error{"not a binary gltf file"};
+    if(readUint32(data + 4) != 2) throw std::runtime_error{"only gltf 2.0 is supported"};
+    size_t const length = std::min<size_t>(readUint32(data + 8), size);
+
+    // chunks follow the 12 byte header, JSON first, then optionally BIN
+    char const *json = nullptr, *bin = nullptr;
+    size_t jsonSize = 0, binSize = 0;
+    for(size_t offset = 12; offset + 8 <= length;) {
+        size_t chunkSize = readUint32(data + offset);
+        uint32_t chunkType = readUint32(data + offset + 4);
+        if(chunkSize > length - offset - 8) throw std::runtime_error{"truncated chunk"};
+        if(chunkType == CHUNK_JSON && !json) { json = data + offset + 8; jsonSize = chunkSize; }
+        else if(chunkType == CHUNK_BIN && !bin) { bin = data + offset + 8; binSize = chunkSize; }
+        offset += 8 + chunkSize;
+    }
+    if(!json) throw std::runtime_error{"no JSON chunk"};
+
+    try {
+        nlohmann::json const document = nlohmann::json::parse(json, json + jsonSize);
+        for(nlohmann::json const &mesh : document.value("meshes", nlohmann::json::array())) {
+            for(nlohmann::json const &primitive : mesh.at("primitives")) {
+                if(primitive.value("mode", MODE_TRIANGLES) != MODE_TRIANGLES) throw std::runtime_error{"only triangle lists are supported"};
+                nlohmann::json const &attributes = primitive.at("attributes");
+                Primitive result;
+                result.position = readAccessor(document, attributes.at("POSITION").get<size_t>(), bin, binSize);
+                if(attributes.contains("NORMAL")) result.normal = readAccessor(document, attributes["NORMAL"].get<size_t>(), bin, binSize);
+                if(attributes.contains("TEXCOORD_0")) result.texCoord = readAccessor(document, attributes["TEXCOORD_0"].get<size_t>(), bin, binSize);
+                if(primitive.contains("indices")) result.indices = readAccessor(document, primitive["indices"].get<size_t>(), bin, binSize);
+                m_primitives.push_back(result);
+            }
+        }
+    } catch(nlohmann::json::exception const &e) {
+        throw std::runtime_error{std::string{"malformed gltf: "} + e.what()};
+    }
+    if(m_primitives.empty()) throw std::runtime_error{"no mesh primitives"};
+}
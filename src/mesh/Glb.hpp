@@ -0,0 +1,48 @@
+#pragma once
+#include "MappedFile.hpp"
+#include <filesystem>
+#include <optional>
+#include <cstdint>
+#include <vector>
+
+/*
+binary gltf 2.0. the file is mapped and the accessors point into its BIN chunk, nothing is copied or converted.
+only what a preview mesh needs: triangle list primitives with POSITION, NORMAL, TEXCOORD_0 and indices.
+sparse accessors, external buffers and data uris are rejected
+*/
+namespace mesh
+{
+    class GlbFile
+    {
+    public:
+        struct Accessor {
+            char const *data = nullptr;     // the first element
+            uint32_t count = 0;
+            uint32_t componentType = 0;     // gltf uses the gl enum values, GL_FLOAT, GL_UNSIGNED_SHORT, ...
+            unsigned components = 0;        // 1 for SCALAR up to 4 for VEC4
+            unsigned stride = 0;            // bytes from one element to the next
+            bool normalized = false;
+
+            size_t getElementSize() const noexcept;
+            // the bytes from the first element to the end of the last
+            size_t getByteLength() const noexcept;
+            // the largest value of an unsigned integer scalar accessor, 0 for any other type
+            uint32_t getMaxValue() const noexcept;
+        };
+        struct Primitive {
+            Accessor position;
+            std::optional<Accessor> normal;
+            std::optional<Accessor> texCoord;
+            std::optional<Accessor> indices;    // vertices in order when absent
+        };
+    private:
+        MappedFile m_file;
+        std::vector<Primitive> m_primitives;
+    public:
+        // throws std::runtime_error on a malformed file or a feature the reader does not handle
+        explicit GlbFile(std::filesystem::path const &path);
+
+        // of every mesh, in file order. valid as long as this object
+        inline std::vector<Primitive> const &getPrimitives() const noexcept { return m_primitives; }
+    };
+} // namespace mesh
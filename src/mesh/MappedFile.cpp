@@ -0,0 +1,68 @@
+#include "MappedFile.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+mesh::MappedFile::MappedFile(std::filesystem::path const &path)
+{
+#ifdef MAPPED_FILE_MMAP
+    int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(descriptor < 0) throw std::runtime_error{"failed to open \"" + path.string() + "\""};
+    struct stat status;
+    if(fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error{"failed to stat \"" + path.string() + "\""};
+    }
+    m_size = size_t(status.st_size);
+    // an empty file can't be mapped, there is nothing to read anyway
+    if(m_size > 0) {
+        void *mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(mapping != MAP_FAILED) {
+            m_mapping = mapping;
+            m_data = static_cast<char const *>(mapping);
+        }
+    }
+    ::close(descriptor);
+    if(m_mapping || m_size == 0) return;
+#endif
+    std::ifstream file{path, std::ios::binary};
+    if(!file) throw std::runtime_error{"failed to open \"" + path.string() + "\""};
+    m_contents.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    m_data = m_contents.data();
+    m_size = m_contents.size();
+}
+mesh::MappedFile::~MappedFile() { close(); }
+
+mesh::MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+mesh::MappedFile &mesh::MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if(this == &other) return *this;
+    close();
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_contents = std::move(other.m_contents);
+    // moving the vector keeps its buffer
+    m_data = m_mapping ? static_cast<char const *>(m_mapping) : m_contents.data();
+    other.m_data = nullptr;
+    return *this;
+}
+
+void mesh::MappedFile::close() noexcept
+{
+#ifdef MAPPED_FILE_MMAP
+    if(m_mapping) munmap(m_mapping, m_size);
+#endif
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_contents.clear();
+}
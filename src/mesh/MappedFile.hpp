@@ -0,0 +1,34 @@
+#pragma once
+#include <filesystem>
+#include <cstddef>
+#include <vector>
+
+namespace mesh
+{
+    /*
+    a whole file, read only. mapped where mmap exists, so the pages come straight from the page cache and
+    can be handed to glBufferData without a copy. elsewhere the file is read into memory
+    */
+    class MappedFile
+    {
+    private:
+        void *m_mapping = nullptr;
+        char const *m_data = nullptr;
+        size_t m_size = 0;
+        std::vector<char> m_contents;   // when not mapped
+
+        void close() noexcept;
+    public:
+        MappedFile() = default;
+        // throws std::runtime_error when the file can't be opened
+        explicit MappedFile(std::filesystem::path const &path);
+        ~MappedFile();
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+        MappedFile(MappedFile const &) = delete;
+        MappedFile &operator=(MappedFile const &) = delete;
+
+        inline char const *data() const noexcept { return m_data; }
+        inline size_t size() const noexcept { return m_size; }
+    };
+} // namespace mesh
@@ -0,0 +1,254 @@
+#include "ObjReader.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t MIN_CHUNK_SIZE = 1 << 20;     // smaller files are not worth the threads
+    constexpr unsigned CHUNKS_PER_WORKER = 4;      // lines differ in cost, faces take longer than vertices
+
+    enum Attribute { POSITION, NORMAL, TEXCOORD, NUM_ATTRIBUTES };
+
+    struct Chunk {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> texCoords;
+        std::vector<mesh::ObjData::Corner> corners;     // of every face, before triangulation
+        std::vector<uint8_t> faceSizes;                 // 3 or 4
+        // negative indices count back from the line they are on, they are resolved against this chunk's
+        // own counts while parsing and need the counts of the chunks before it added
+        std::vector<std::pair<size_t, Attribute>> relative;
+        size_t numTriangles = 0;
+        bool unsupported = false;
+    };
+
+    inline bool isSpace(char c) noexcept { return c == ' ' || c == '\t'; }
+    inline bool isLineEnd(char c) noexcept { return c == '\n' || c == '\r'; }
+
+    class LineParser
+    {
+    private:
+        char const *m_at;
+        char const *m_end;  // of the line, before the newline
+    public:
+        LineParser(char const *begin, char const *end) noexcept : m_at(begin), m_end(end) {}
+
+        void skipSpace() noexcept { while(m_at < m_end && isSpace(*m_at)) ++m_at; }
+        bool atEnd() const noexcept { return m_at >= m_end || *m_at == '#'; }
+
+        // parsed as a double and rounded like tinyobj does, the whole token has to be a number
+        bool parseFloat(float &value) noexcept
+        {
+            skipSpace();
+            char const *begin = m_at;
+            while(m_at < m_end && !isSpace(*m_at)) ++m_at;
+            if(begin < m_at && *begin == '+') ++begin;
+            double parsed;
+            auto [end, error] = std::from_chars(begin, m_at, parsed);
+            if(error != std::errc{} || end != m_at) return false;
+            value = float(parsed);
+            return true;
+        }
+        // a signed integer, 0 when there are no digits like atoi
+        bool parseIndex(int64_t &value) noexcept
+        {
+            bool negative = m_at < m_end && *m_at == '-';
+            if(m_at < m_end && (*m_at == '-' || *m_at == '+')) ++m_at;
+            value = 0;
+            while(m_at < m_end && *m_at >= '0' && *m_at <= '9') {
+                value = value * 10 + (*m_at++ - '0');
+                if(value > INT32_MAX) return false;
+            }
+            if(negative) value = -value;
+            return m_at >= m_end || *m_at == '/' || isSpace(*m_at) || *m_at == '#';
+        }
+        bool skip(char c) noexcept
+        {
+            if(m_at < m_end && *m_at == c) {
+                ++m_at;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    // one of i, i/j, i//k, i/j/k. obj indices start at 1, negative ones count back from the current line
+    bool parseCorner(LineParser &line, Chunk &chunk, mesh::ObjData::Corner &corner)
+    {
+        size_t const counts[NUM_ATTRIBUTES] = { chunk.positions.size() / 3, chunk.normals.size() / 3, chunk.texCoords.size() / 2 };
+        auto resolve = [&](int64_t index, Attribute attribute, int32_t &result) {
+            if(index > 0) {
+                result = int32_t(index - 1);
+            } else if(index < 0) {
+                result = int32_t(int64_t(counts[attribute]) + index);
+                chunk.relative.push_back({ chunk.corners.size(), attribute });
+            } else {
+                // tinyobj takes a zero normal or texcoord as absent with a warning, a zero position is an error
+                if(attribute == POSITION) return false;
+                result = -1;
+            }
+            return true;
+        };
+
+        int64_t index;
+        if(!line.parseIndex(index) || !resolve(index, POSITION, corner.position)) return false;
+        if(!line.skip('/')) return true;
+        if(!line.skip('/')) {
+            if(!line.parseIndex(index) || !resolve(index, TEXCOORD, corner.texCoord)) return false;
+            if(!line.skip('/')) return true;
+        }
+        return line.parseIndex(index) && resolve(index, NORMAL, corner.normal);
+    }
+
+    void parseChunk(char const *begin, char const *end, Chunk &chunk)
+    {
+        for(char const *lineBegin = begin; lineBegin < end;) {
+            char const *lineEnd = static_cast<char const *>(std::memchr(lineBegin, '\n', size_t(end - lineBegin)));
+            if(!lineEnd) lineEnd = end;
+            char const *next = lineEnd + 1;
+            while(lineEnd > lineBegin && isLineEnd(lineEnd[-1])) --lineEnd;
+
+            char const *token = lineBegin;
+            while(token < lineEnd && isSpace(*token)) ++token;
+            size_t length = size_t(lineEnd - token);
+            auto keyword = [&](char const *name, size_t size) { return length > size && std::memcmp(token, name, size) == 0 && isSpace(token[size]); };
+
+            bool ok = true;
+            float values[3];
+            if(keyword("v", 1)) {
+                LineParser line{token + 2, lineEnd};
+                ok = line.parseFloat(values[0]) && line.parseFloat(values[1]) && line.parseFloat(values[2]);
+                chunk.positions.insert(chunk.positions.end(), values, values + 3);
+            } else if(keyword("vn", 2)) {
+                LineParser line{token + 3, lineEnd};
+                ok = line.parseFloat(values[0]) && line.parseFloat(values[1]) && line.parseFloat(values[2]);
+                chunk.normals.insert(chunk.normals.end(), values, values + 3);
+            } else if(keyword("vt", 2)) {
+                LineParser line{token + 3, lineEnd};
+                ok = line.parseFloat(values[0]) && line.parseFloat(values[1]);
+                chunk.texCoords.insert(chunk.texCoords.end(), values, values + 2);
+            } else if(keyword("f", 1)) {
+                LineParser line{token + 2, lineEnd};
+                size_t first = chunk.corners.size();
+                size_t firstRelative = chunk.relative.size();
+                for(line.skipSpace(); ok && !line.atEnd(); line.skipSpace()) {
+                    mesh::ObjData::Corner corner;
+                    ok = parseCorner(line, chunk, corner);
+                    chunk.corners.push_back(corner);
+                }
+                size_t size = chunk.corners.size() - first;
+                if(ok && size > 4) ok = false;
+                if(ok && size < 3) {
+                    // tinyobj drops degenerate faces with a warning
+                    chunk.corners.resize(first);
+                    chunk.relative.resize(firstRelative);
+                } else if(ok) {
+                    chunk.faceSizes.push_back(uint8_t(size));
+                    chunk.numTriangles += size - 2;
+                }
+            }
+            // anything else, comments, groups, materials, lines and points, does not change the triangles
+            if(!ok) {
+                chunk.unsupported = true;
+                return;
+            }
+            lineBegin = next;
+        }
+    }
+
+    bool isValid(mesh::ObjData::Corner const &corner, size_t const counts[NUM_ATTRIBUTES]) noexcept
+    {
+        return corner.position >= 0 && size_t(corner.position) < counts[POSITION] &&
+            corner.normal >= -1 && (corner.normal < 0 || size_t(corner.normal) < counts[NORMAL]) &&
+            corner.texCoord >= -1 && (corner.texCoord < 0 || size_t(corner.texCoord) < counts[TEXCOORD]);
+    }
+} // namespace
+
+std::optional<mesh::ObjData> mesh::readObj(char const *data, size_t size)
+{
+    size_t numChunks = std::max<size_t>(1, std::min<size_t>(size / MIN_CHUNK_SIZE, size_t(parallel::getNumWorkers()) * CHUNKS_PER_WORKER));
+    // every chunk starts at the beginning of a line
+    std::vector<size_t> boundaries(numChunks + 1, size);
+    boundaries[0] = 0;
+    for(size_t i = 1; i < numChunks; ++i) {
+        size_t nominal = std::max(size * i / numChunks, boundaries[i - 1]);
+        char const *newline = nominal == 0 ? nullptr : static_cast<char const *>(std::memchr(data + nominal - 1, '\n', size - nominal + 1));
+        boundaries[i] = newline ? size_t(newline - data) + 1 : size;
+    }
+
+    std::vector<Chunk> chunks(numChunks);
+    parallel::forEach(numChunks, [&](size_t i) {
+        parseChunk(data + boundaries[i], data + boundaries[i + 1], chunks[i]);
+    });
+
+    // prefix sums, where each chunk's data lands in the merged arrays
+    std::vector<size_t> bases[NUM_ATTRIBUTES];
+    std::vector<size_t> triangleBases(numChunks + 1, 0);
+    for(std::vector<size_t> &base : bases) base.assign(numChunks + 1, 0);
+    for(size_t i = 0; i < numChunks; ++i) {
+        if(chunks[i].unsupported) return std::nullopt;
+        bases[POSITION][i + 1] = bases[POSITION][i] + chunks[i].positions.size() / 3;
+        bases[NORMAL][i + 1] = bases[NORMAL][i] + chunks[i].normals.size() / 3;
+        bases[TEXCOORD][i + 1] = bases[TEXCOORD][i] + chunks[i].texCoords.size() / 2;
+        triangleBases[i + 1] = triangleBases[i] + chunks[i].numTriangles;
+    }
+    size_t const counts[NUM_ATTRIBUTES] = { bases[POSITION][numChunks], bases[NORMAL][numChunks], bases[TEXCOORD][numChunks] };
+    if(counts[POSITION] > size_t(INT32_MAX)) return std::nullopt;
+
+    ObjData result;
+    result.positions.resize(counts[POSITION] * 3);
+    result.normals.resize(counts[NORMAL] * 3);
+    result.texCoords.resize(counts[TEXCOORD] * 2);
+    result.corners.resize(triangleBases[numChunks] * 3);
+
+    parallel::forEach(numChunks, [&](size_t i) {
+        Chunk &chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + bases[POSITION][i] * 3);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + bases[NORMAL][i] * 3);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), result.texCoords.begin() + bases[TEXCOORD][i] * 2);
+        for(auto const &[corner, attribute] : chunk.relative) {
+            ObjData::Corner &fixed = chunk.corners[corner];
+            int32_t &index = attribute == POSITION ? fixed.position : attribute == NORMAL ? fixed.normal : fixed.texCoord;
+            index += int32_t(bases[attribute][i]);
+            // counted back past the start of the file, tinyobj errors. -1 would read as absent
+            if(index < 0) index = INT32_MIN;
+        }
+    });
+
+    // quads need positions from anywhere in the file, all chunks are merged by now
+    std::atomic_bool valid = true;
+    parallel::forEach(numChunks, [&](size_t i) {
+        Chunk const &chunk = chunks[i];
+        ObjData::Corner *out = result.corners.data() + triangleBases[i] * 3;
+        ObjData::Corner const *face = chunk.corners.data();
+        for(uint8_t faceSize : chunk.faceSizes) {
+            for(unsigned k = 0; k < faceSize; ++k) {
+                if(!isValid(face[k], counts)) {
+                    valid = false;
+                    return;
+                }
+            }
+            if(faceSize == 3) {
+                out = std::copy(face, face + 3, out);
+            } else {
+                // the shorter diagonal, in the same float math as tinyobj so ties split the same way
+                float const *p[4];
+                for(unsigned k = 0; k < 4; ++k) p[k] = &result.positions[size_t(face[k].position) * 3];
+                float e02x = p[2][0] - p[0][0], e02y = p[2][1] - p[0][1], e02z = p[2][2] - p[0][2];
+                float e13x = p[3][0] - p[1][0], e13y = p[3][1] - p[1][1], e13z = p[3][2] - p[1][2];
+                float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+                float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+                static constexpr unsigned SPLIT_02[6] = { 0, 1, 2, 0, 2, 3 };
+                static constexpr unsigned SPLIT_13[6] = { 0, 1, 3, 1, 2, 3 };
+                unsigned const *split = sqr02 < sqr13 ? SPLIT_02 : SPLIT_13;
+                for(unsigned k = 0; k < 6; ++k) *out++ = face[split[k]];
+            }
+            face += faceSize;
+        }
+    });
+    if(!valid) return std::nullopt;
+    return result;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+a parallel reader for the obj subset meshes are exported with: v, vn, vt and triangle or quad faces, the rest is skipped.
+the file is split into newline aligned chunks parsed on all workers, then merged with prefix sums over the per chunk counts.
+the result matches what tinyobj builds for these files, quads are split along the shorter diagonal as it does
+*/
+namespace mesh
+{
+    struct ObjData {
+        // 0 based, -1 when the face leaves it out. same layout as tinyobj::index_t
+        struct Corner {
+            int32_t position = -1;
+            int32_t normal = -1;
+            int32_t texCoord = -1;
+        };
+        std::vector<float> positions;   // xyz
+        std::vector<float> normals;     // xyz
+        std::vector<float> texCoords;   // uv
+        std::vector<Corner> corners;    // three per triangle, in file order
+    };
+
+    // nullopt when the file needs a full reader: polygons above quads, zero or out of range indices, numbers that
+    // don't parse. tinyobj handles those, and reports the errors
+    std::optional<ObjData> readObj(char const *data, size_t size);
+} // namespace mesh
@@ -0,0 +1,142 @@
+#include "Optimize.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+    // the constants from "Linear-Speed Vertex Cache Optimisation", Tom Forsyth
+    constexpr float CACHE_DECAY_POWER = 1.5f;
+    constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float VALENCE_BOOST_POWER = 0.5f;
+    constexpr uint32_t NONE = ~0u;
+
+    float vertexScore(int cachePosition, unsigned remainingTriangles)
+    {
+        if(remainingTriangles == 0) return -1;
+        float score = 0;
+        if(cachePosition >= 3) {
+            float const scaler = 1.0f / (mesh::VERTEX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        } else if(cachePosition >= 0) {
+            // the triangle just emitted, fixed so it does not matter which of its edges the next one shares
+            score = LAST_TRIANGLE_SCORE;
+        }
+        // vertices with few triangles left are finished off before they drop out of the cache
+        return score + VALENCE_BOOST_SCALE * std::pow(float(remainingTriangles), -VALENCE_BOOST_POWER);
+    }
+} // namespace
+
+void mesh::optimizeVertexCache(std::vector<uint32_t> &indices, size_t numVertices)
+{
+    assert(indices.size() % 3 == 0);
+    size_t const numTriangles = indices.size() / 3;
+    if(numTriangles == 0) return;
+
+    // the triangles of every vertex, packed. the first remaining[v] entries of a vertex are the ones not emitted yet
+    std::vector<unsigned> remaining(numVertices, 0);
+    for(uint32_t index : indices) ++remaining[index];
+    std::vector<size_t> firstTriangle(numVertices + 1, 0);
+    for(size_t v = 0; v < numVertices; ++v) firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<size_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+        for(size_t i = 0; i < indices.size(); ++i) adjacency[cursor[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    std::vector<int> cachePosition(numVertices, -1);
+    std::vector<float> score(numVertices);
+    for(size_t v = 0; v < numVertices; ++v) score[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(numTriangles);
+    std::vector<bool> emitted(numTriangles, false);
+    uint32_t best = 0;
+    for(size_t t = 0; t < numTriangles; ++t) {
+        triangleScore[t] = score[indices[3*t]] + score[indices[3*t+1]] + score[indices[3*t+2]];
+        if(triangleScore[t] > triangleScore[best]) best = uint32_t(t);
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    for(size_t numEmitted = 0; numEmitted < numTriangles; ++numEmitted) {
+        if(best == NONE) {
+            // nothing in the cache has triangles left, continue with the next one in the input order instead of searching all
+            while(emitted[scanCursor]) ++scanCursor;
+            best = uint32_t(scanCursor);
+        }
+        uint32_t const *triangle = &indices[3*size_t(best)];
+        emitted[best] = true;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        for(unsigned corner = 0; corner < 3; ++corner) {
+            uint32_t v = triangle[corner];
+            uint32_t *begin = &adjacency[firstTriangle[v]];
+            uint32_t *last = begin + --remaining[v];
+            *std::find(begin, last + 1, best) = *last;
+        }
+
+        // lru, the new triangle goes to the front
+        nextCache.assign(triangle, triangle + 3);
+        for(uint32_t v : cache) {
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2]) nextCache.push_back(v);
+        }
+        for(size_t i = 0; i < nextCache.size(); ++i) {
+            uint32_t v = nextCache[i];
+            cachePosition[v] = i < VERTEX_CACHE_SIZE ? int(i) : -1;
+            float newScore = vertexScore(cachePosition[v], remaining[v]);
+            float delta = newScore - score[v];
+            score[v] = newScore;
+            for(size_t a = firstTriangle[v]; a < firstTriangle[v] + remaining[v]; ++a) triangleScore[adjacency[a]] += delta;
+        }
+        if(nextCache.size() > VERTEX_CACHE_SIZE) nextCache.resize(VERTEX_CACHE_SIZE);
+        std::swap(cache, nextCache);
+
+        // only triangles touching the cache changed their score, the best one is among them or there is none
+        best = NONE;
+        float bestScore = -1;
+        for(uint32_t v : cache) {
+            for(size_t a = firstTriangle[v]; a < firstTriangle[v] + remaining[v]; ++a) {
+                if(triangleScore[adjacency[a]] > bestScore) {
+                    bestScore = triangleScore[adjacency[a]];
+                    best = adjacency[a];
+                }
+            }
+        }
+    }
+    indices = std::move(result);
+}
+
+std::vector<uint32_t> mesh::optimizeVertexFetch(std::vector<uint32_t> &indices, size_t numVertices)
+{
+    std::vector<uint32_t> newIndex(numVertices, NONE);
+    std::vector<uint32_t> order;
+    order.reserve(numVertices);
+    for(uint32_t &index : indices) {
+        if(newIndex[index] == NONE) {
+            newIndex[index] = uint32_t(order.size());
+            order.push_back(index);
+        }
+        index = newIndex[index];
+    }
+    // unreferenced vertices are dropped
+    return order;
+}
+
+float mesh::computeACMR(std::vector<uint32_t> const &indices, size_t numVertices, unsigned cacheSize)
+{
+    if(indices.size() < 3) return 0;
+    // the time each vertex entered the fifo, it is still in there while less than cacheSize misses happened since
+    std::vector<size_t> entered(numVertices, 0);
+    size_t misses = 0;
+    for(uint32_t index : indices) {
+        if(misses - entered[index] < cacheSize && entered[index] != 0) continue;
+        ++misses;
+        entered[index] = misses;
+    }
+    return float(misses) / float(indices.size() / 3);
+}
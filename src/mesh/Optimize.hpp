@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+index buffer optimisation, independent of the vertex format. indices are a triangle list
+*/
+namespace mesh
+{
+    constexpr unsigned VERTEX_CACHE_SIZE = 32;
+
+    // reorders the triangles so vertices are reused while still in the post-transform cache (Forsyth, linear speed)
+    void optimizeVertexCache(std::vector<uint32_t> &indices, size_t numVertices);
+    // renumbers vertices in the order the indices first use them, returns the old index of every new vertex.
+    // run after optimizeVertexCache, the vertex fetch then walks memory mostly forward
+    std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t> &indices, size_t numVertices);
+    // vertex shader runs per triangle for a fifo cache of the given size, 0.5 is the best a regular grid can do, 3 is no reuse at all
+    float computeACMR(std::vector<uint32_t> const &indices, size_t numVertices, unsigned cacheSize = 16);
+
+    // copies a vertex attribute array into the order returned by optimizeVertexFetch
+    template <typename T>
+    inline std::vector<T> remap(std::vector<T> const &values, std::vector<uint32_t> const &order)
+    {
+        std::vector<T> result;
+        result.reserve(order.size());
+        for(uint32_t index : order) result.push_back(values[index]);
+        return result;
+    }
+} // namespace mesh
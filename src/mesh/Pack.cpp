@@ -0,0 +1,47 @@
+#include "Pack.hpp"
+#include "glm/gtc/packing.hpp"
+#include <cassert>
+#include <limits>
+
+mesh::Bounds mesh::computeBounds(std::vector<glm::vec3> const &positions) noexcept
+{
+    if(positions.empty()) return {};
+    Bounds bounds{positions[0], positions[0]};
+    for(glm::vec3 const &position : positions) {
+        bounds.min = glm::min(bounds.min, position);
+        bounds.max = glm::max(bounds.max, position);
+    }
+    return bounds;
+}
+
+// x in the lowest bits, the layout GL_INT_2_10_10_10_REV expects
+uint32_t mesh::packNormal(glm::vec3 const &normal) noexcept { return glm::packSnorm3x10_1x2(glm::vec4{normal, 0}); }
+uint32_t mesh::packTexCoord(glm::vec2 const &texCoord) noexcept { return glm::packHalf2x16(texCoord); }
+
+std::vector<mesh::PackedVertex> mesh::pack(std::vector<glm::vec3> const &positions, std::vector<glm::vec3> const &normals, std::vector<glm::vec2> const &texCoords)
+{
+    assert(positions.size() == normals.size() && positions.size() == texCoords.size());
+    std::vector<PackedVertex> vertices(positions.size());
+    for(size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = { positions[i], packNormal(normals[i]), packTexCoord(texCoords[i]) };
+    }
+    return vertices;
+}
+
+std::vector<mesh::QuantizedVertex> mesh::packQuantized(std::vector<glm::vec3> const &positions, std::vector<glm::vec3> const &normals, std::vector<glm::vec2> const &texCoords, Bounds const &bounds)
+{
+    assert(positions.size() == normals.size() && positions.size() == texCoords.size());
+    float const max = std::numeric_limits<uint16_t>::max();
+    // flat along an axis, everything quantizes to 0 there
+    glm::vec3 inverseScale = 1.0f / glm::max(bounds.getScale(), glm::vec3{std::numeric_limits<float>::min()});
+    std::vector<QuantizedVertex> vertices(positions.size());
+    for(size_t i = 0; i < vertices.size(); ++i) {
+        glm::vec3 quantized = glm::round(glm::clamp((positions[i] - bounds.getOffset()) * inverseScale, 0.0f, 1.0f) * max);
+        vertices[i] = {
+            { uint16_t(quantized.x), uint16_t(quantized.y), uint16_t(quantized.z), 0 },
+            packNormal(normals[i]),
+            packTexCoord(texCoords[i])
+        };
+    }
+    return vertices;
+}
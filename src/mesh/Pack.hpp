@@ -0,0 +1,41 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <cstdint>
+#include <vector>
+
+/*
+compact interleaved vertex formats. normals are GL_INT_2_10_10_10_REV, texcoords two GL_HALF_FLOATs (exact up to 1/2048 in [0, 1]),
+both normalized attributes. positions are floats or, quantized, normalized GL_UNSIGNED_SHORTs within the bounds of the mesh,
+undone in the vertex shader by position * scale + offset
+*/
+namespace mesh
+{
+    struct Bounds {
+        glm::vec3 min{0};
+        glm::vec3 max{0};
+        // position = quantized * scale + offset, quantized in [0, 1]
+        inline glm::vec3 getScale() const noexcept { return max - min; }
+        inline glm::vec3 getOffset() const noexcept { return min; }
+    };
+
+    // 20 bytes
+    struct PackedVertex {
+        glm::vec3 position;
+        uint32_t normal;
+        uint32_t texCoord;
+    };
+    // 16 bytes, the fourth position component is padding
+    struct QuantizedVertex {
+        uint16_t position[4];
+        uint32_t normal;
+        uint32_t texCoord;
+    };
+
+    Bounds computeBounds(std::vector<glm::vec3> const &positions) noexcept;
+    uint32_t packNormal(glm::vec3 const &normal) noexcept;
+    uint32_t packTexCoord(glm::vec2 const &texCoord) noexcept;
+
+    // the three arrays have the same size
+    std::vector<PackedVertex> pack(std::vector<glm::vec3> const &positions, std::vector<glm::vec3> const &normals, std::vector<glm::vec2> const &texCoords);
+    std::vector<QuantizedVertex> packQuantized(std::vector<glm::vec3> const &positions, std::vector<glm::vec3> const &normals, std::vector<glm::vec2> const &texCoords, Bounds const &bounds);
+} // namespace mesh
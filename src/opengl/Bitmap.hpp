@@ -1,6 +1,8 @@
 #pragma once
 #include "glm/glm.hpp"
 #include <vector>
+#include <algorithm>
+#include <cassert>
 
 template <typename Format_t = float>
 class Bitmap
@@ -1,4 +1,5 @@
 #include "Framebuffer.hpp"
+#include "StateCache.hpp"
 
 ogl::Framebuffer::Framebuffer(unsigned)
 {
@@ -7,13 +8,14 @@ ogl::Framebuffer::Framebuffer(unsigned)
 ogl::Framebuffer::~Framebuffer()
 {
     if(canDeallocate()) {
+        getStateCache().forgetFramebuffer(m_renderID);
         glDeleteFramebuffers(1, &m_renderID);
     }
 }
 
 void ogl::Framebuffer::bind(unsigned slot) const noexcept
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_renderID);
+    getStateCache().bindFramebuffer(m_renderID);
 }
 bool ogl::Framebuffer::isComplete()
 {
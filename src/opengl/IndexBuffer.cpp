@@ -2,16 +2,14 @@
 
 ogl::IndexBuffer::IndexBuffer(size_t size, GLenum usage) noexcept
 {
-    glGenBuffers(1, &m_renderID);
-    bind();
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, nullptr, usage);
+    glCreateBuffers(1, &m_renderID);
+    glNamedBufferData(m_renderID, size, nullptr, usage);
 }
 
 ogl::IndexBuffer::IndexBuffer(size_t size, void const *data, GLenum usage) noexcept
 {
-    glGenBuffers(1, &m_renderID);
-    bind();
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, usage);
+    glCreateBuffers(1, &m_renderID);
+    glNamedBufferData(m_renderID, size, data, usage);
 }
 
 ogl::IndexBuffer::~IndexBuffer()
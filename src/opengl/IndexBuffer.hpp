@@ -5,6 +5,8 @@
 
 namespace ogl
 {
+    // created without binding, GL_ELEMENT_ARRAY_BUFFER belongs to whatever vertex array is bound.
+    // attach it with VertexArray::setIndexBuffer
     class IndexBuffer : public Object 
     {
     public:
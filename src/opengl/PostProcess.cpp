@@ -0,0 +1,187 @@
+#include "PostProcess.hpp"
+#include "StateCache.hpp"
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cassert>
+
+char const *ogl::postSettingsToString(PostSettings const &settings) noexcept
+{
+    if(settings.antiAliasing == AntiAliasing::MSAA && settings.path == PostPath::COMPUTE) return "msaa, compute";
+    if(settings.antiAliasing == AntiAliasing::FXAA) return settings.srgbDisplay ? "fxaa" : "fxaa, rgba16f";
+    if(settings.resolveMode == ResolveMode::BLIT) return settings.srgbDisplay ? "msaa, blit resolve" : "msaa, blit resolve, rgba16f";
+    return settings.srgbDisplay ? "msaa, shader resolve" : "msaa, shader resolve, rgba16f";
+}
+
+ogl::PostProcess::PostProcess(RenderTargetPool &pool, unsigned numSamples) :
+    m_pool(pool),
+    m_resolveShader{"shaders/hdrImage", true, {{"NUM_SAMPLES", std::to_string(numSamples)}}},
+    m_tonemapShader{"shaders/tonemap"},
+    m_fxaaShader{"shaders/tonemap", true, {{"FXAA", "1"}}},
+    m_computeShader{"shaders/postCompute", true, {{"NUM_SAMPLES", std::to_string(numSamples)}}},
+    m_msaa(pool.createTarget({
+        {GL_COLOR_ATTACHMENT0, GL_RGBA16F, numSamples},
+        {GL_DEPTH_STENCIL_ATTACHMENT, GL_DEPTH24_STENCIL8, numSamples, true}
+    })),
+    m_resolve(pool.createTarget({
+        {GL_COLOR_ATTACHMENT0, GL_RGBA16F}
+    })),
+    m_aliased(pool.createTarget({
+        {GL_COLOR_ATTACHMENT0, GL_RGBA16F},
+        {GL_DEPTH_STENCIL_ATTACHMENT, GL_DEPTH24_STENCIL8, 0, true}
+    })),
+    m_display(pool.createTarget({
+        {GL_COLOR_ATTACHMENT0, GL_RGBA16F}
+    })),
+    m_srgbDisplay(pool.createTarget({
+        {GL_COLOR_ATTACHMENT0, GL_SRGB8_ALPHA8}
+    })),
+    m_computeDisplay(pool.createTarget({
+        {GL_COLOR_ATTACHMENT0, GL_RGBA8}
+    }))
+{
+}
+ogl::PostProcess::~PostProcess()
+{
+    deleteDisplayView();
+}
+
+void ogl::PostProcess::deleteDisplayView() noexcept
+{
+    if(m_srgbDisplayView) {
+        getStateCache().forgetTexture(m_srgbDisplayView);
+        glDeleteTextures(1, &m_srgbDisplayView);
+    }
+    m_srgbDisplayView = 0;
+    m_srgbDisplayViewSource = 0;
+}
+
+std::vector<ogl::RenderTarget *> ogl::PostProcess::getTargets(PostSettings const &settings) const
+{
+    RenderTarget *display = settings.srgbDisplay ? &m_srgbDisplay : &m_display;
+    if(settings.antiAliasing == AntiAliasing::FXAA) return { &m_aliased, display };
+    if(settings.path == PostPath::COMPUTE) return { &m_msaa, &m_computeDisplay };
+    if(settings.resolveMode == ResolveMode::BLIT) return { &m_msaa, &m_resolve, display };
+    return { &m_msaa, display };
+}
+
+ogl::RenderTarget &ogl::PostProcess::prepare(PostSettings const &settings, glm::ivec2 viewport)
+{
+    std::vector<RenderTarget *> targets = getTargets(settings);
+    bool released = false;
+    for(RenderTarget *target : { &m_msaa, &m_resolve, &m_aliased, &m_display, &m_srgbDisplay, &m_computeDisplay }) {
+        if(std::find(targets.begin(), targets.end(), target) == targets.end()) released |= m_pool.release(*target);
+    }
+    // the view keeps the storage alive
+    if(std::find(targets.begin(), targets.end(), &m_srgbDisplay) == targets.end()) deleteDisplayView();
+    if(released) m_pool.trim(); // switching modes should actually free the memory
+    // only does gl work when the size leaves its bucket or the settings change
+    for(RenderTarget *target : targets) m_pool.resize(*target, viewport);
+    return *targets.front();
+}
+
+void ogl::PostProcess::apply(PostSettings const &settings, glm::ivec2 viewport)
+{
+    StateCache &state = getStateCache();
+    assert(getDisplay(settings).getViewport() == viewport);
+    if(settings.antiAliasing == AntiAliasing::MSAA && settings.path == PostPath::COMPUTE) {
+        m_computeShader.bind();
+        glUniform1f(m_computeShader.getUniform(m_computeUniforms.exposure), settings.exposure);
+        glUniform2i(m_computeShader.getUniform(m_computeUniforms.viewport), viewport.x, viewport.y);
+        state.bindTextureUnit(0, m_msaa.getAttachment(0));
+        glBindImageTexture(0, m_computeDisplay.getAttachment(0), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        glDispatchCompute((viewport.x + 7) / 8, (viewport.y + 7) / 8, 1);
+        // imgui samples the image later in the frame
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        return;
+    }
+
+    ShaderProgram const *shader = nullptr;
+    PostUniforms const *uniforms = nullptr;
+    if(settings.antiAliasing == AntiAliasing::FXAA) {
+        shader = &m_fxaaShader;
+        uniforms = &m_fxaaUniforms;
+        state.bindTextureUnit(0, m_aliased.getAttachment(0));
+    } else if(settings.resolveMode == ResolveMode::BLIT) {
+        glBlitNamedFramebuffer(
+            m_msaa.getFramebuffer().getRenderID(), m_resolve.getFramebuffer().getRenderID(),
+            0, 0, viewport.x, viewport.y,
+            0, 0, viewport.x, viewport.y,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST
+        );
+        shader = &m_tonemapShader;
+        uniforms = &m_tonemapUniforms;
+        state.bindTextureUnit(0, m_resolve.getAttachment(0));
+    } else {
+        shader = &m_resolveShader;
+        uniforms = &m_resolveUniforms;
+        state.bindTextureUnit(0, m_msaa.getAttachment(0));
+    }
+    shader->bind();
+    glUniform1f(shader->getUniform(uniforms->exposure), settings.exposure);
+    glUniform1i(shader->getUniform(uniforms->gammaCorrect), !settings.srgbDisplay);
+    glUniform2i(shader->getUniform(uniforms->viewport), viewport.x, viewport.y); // -1 in the msaa resolve, ignored
+    getDisplay(settings).bind();
+    state.viewport(0, 0, viewport.x, viewport.y);
+    state.setEnabled(GL_FRAMEBUFFER_SRGB, settings.srgbDisplay);
+    // vertices hard-coded in the shader
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 3);
+    state.setEnabled(GL_FRAMEBUFFER_SRGB, false); // imgui draws to the default framebuffer with it off
+
+    // sampling the srgb texture would decode it back to linear, imgui wants the encoded values
+    if(settings.srgbDisplay && m_srgbDisplayViewSource != m_srgbDisplay.getAttachment(0)) {
+        deleteDisplayView();
+        m_srgbDisplayViewSource = m_srgbDisplay.getAttachment(0);
+        glGenTextures(1, &m_srgbDisplayView); // a view needs a name that was never bound
+        glTextureView(m_srgbDisplayView, GL_TEXTURE_2D, m_srgbDisplayViewSource, GL_RGBA8, 0, 1, 0, 1);
+    }
+}
+
+std::vector<ogl::ShaderProgram *> ogl::PostProcess::getShaders() noexcept
+{
+    return { &m_resolveShader, &m_tonemapShader, &m_fxaaShader, &m_computeShader };
+}
+
+ogl::RenderTarget const &ogl::PostProcess::getDisplay(PostSettings const &settings) const noexcept
+{
+    if(settings.antiAliasing == AntiAliasing::MSAA && settings.path == PostPath::COMPUTE) return m_computeDisplay;
+    return settings.srgbDisplay ? m_srgbDisplay : m_display;
+}
+unsigned ogl::PostProcess::getDisplayTexture(PostSettings const &settings) const noexcept
+{
+    RenderTarget const &display = getDisplay(settings);
+    if(&display == &m_srgbDisplay) return m_srgbDisplayView;
+    return display.getAttachment(0);
+}
+
+size_t ogl::PostProcess::getFootprint(PostSettings const &settings, glm::ivec2 size) const noexcept
+{
+    size_t bytes = 0;
+    for(RenderTarget const *target : getTargets(settings)) bytes += getTargetBytes(*target, size);
+    return bytes;
+}
+
+std::vector<ogl::PostBenchmark> ogl::benchmarkPost(PostProcess &post, std::vector<PostSettings> const &settings, std::vector<glm::ivec2> const &sizes, unsigned iterations)
+{
+    std::vector<PostBenchmark> results;
+    GLint prevFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevFramebuffer);
+    for(glm::ivec2 size : sizes) {
+        for(PostSettings const &setting : settings) {
+            RenderTarget &scene = post.prepare(setting, size);
+            float const color[] = { 0.5f, 1.0f, 2.0f, 1.0f };
+            glClearNamedFramebufferfv(scene.getFramebuffer().getRenderID(), GL_COLOR, 0, color);
+            post.apply(setting, size); // warm up, the first use of a program can compile lazily
+
+            // the cpu clock between two glFinish calls, timer queries are not reliable on every driver
+            glFinish();
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned i = 0; i < iterations; ++i) post.apply(setting, size);
+            glFinish();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            results.push_back({setting, size, seconds * 1.0E3 / std::max(iterations, 1u)});
+        }
+    }
+    getStateCache().bindFramebuffer(prevFramebuffer);
+    return results;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "RenderTargetPool.hpp"
+#include "Shader.hpp"
+#include "glm/glm.hpp"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace ogl
+{
+    enum class AntiAliasing {
+        MSAA,       // multisampled color and depth
+        FXAA        // single sampled, fxaa folded into the tonemap pass
+    };
+    enum class ResolveMode {
+        BLIT,       // hardware resolve into a single sampled target, then tonemap
+        SHADER      // tonemap every sample in the post shader, then average. better bright edges
+    };
+    enum class PostPath {
+        RASTER,     // full-screen triangle into the display target
+        COMPUTE     // one dispatch resolves, tonemaps and gamma encodes into an RGBA8 display target. msaa only
+    };
+    struct PostSettings {
+        AntiAliasing antiAliasing = AntiAliasing::MSAA;
+        ResolveMode resolveMode = ResolveMode::BLIT;
+        PostPath path = PostPath::RASTER;
+        bool srgbDisplay = true;    // raster display target in SRGB8_ALPHA8 encoded by the hardware, RGBA16F with pow() otherwise
+        float exposure = 1;
+
+        inline bool operator==(PostSettings const &other) const noexcept
+        {
+            return antiAliasing == other.antiAliasing && resolveMode == other.resolveMode && path == other.path &&
+                srgbDisplay == other.srgbDisplay && exposure == other.exposure;
+        }
+        inline bool operator!=(PostSettings const &other) const noexcept { return !(*this == other); }
+    };
+    char const *postSettingsToString(PostSettings const &settings) noexcept;
+
+    /*
+    the viewport targets and the passes between the scene and the texture imgui shows.
+    only the targets the current settings need are allocated, the rest go back to the pool
+    */
+    class PostProcess
+    {
+    private:
+        // resolved per program, see UniformHandle
+        struct PostUniforms {
+            UniformHandle exposure{"u_exposure"};
+            UniformHandle gammaCorrect{"u_gammaCorrect"};
+            UniformHandle viewport{"u_viewport"};
+        };
+        RenderTargetPool &m_pool;
+        ShaderProgram m_resolveShader;
+        ShaderProgram m_tonemapShader;
+        ShaderProgram m_fxaaShader;
+        ShaderProgram m_computeShader;
+        PostUniforms m_resolveUniforms, m_tonemapUniforms, m_fxaaUniforms, m_computeUniforms;
+        RenderTarget &m_msaa;
+        RenderTarget &m_resolve;            // blit resolve destination
+        RenderTarget &m_aliased;            // AntiAliasing::FXAA scene
+        RenderTarget &m_display;            // raster output, the post pass does not touch depth
+        RenderTarget &m_srgbDisplay;        // raster output with PostSettings::srgbDisplay
+        RenderTarget &m_computeDisplay;     // PostPath::COMPUTE output
+        // RGBA8 view of the srgb display so imgui reads the encoded bytes as they are, recreated with the attachment
+        unsigned m_srgbDisplayView = 0;
+        unsigned m_srgbDisplayViewSource = 0;
+
+        void deleteDisplayView() noexcept;
+
+        std::vector<RenderTarget *> getTargets(PostSettings const &settings) const;
+    public:
+        PostProcess(RenderTargetPool &pool, unsigned numSamples);
+        ~PostProcess();
+        PostProcess(PostProcess const &) = delete;
+        PostProcess &operator=(PostProcess const &) = delete;
+
+        // allocates the targets the settings need and releases the rest, returns the target to draw the scene into
+        RenderTarget &prepare(PostSettings const &settings, glm::ivec2 viewport);
+        // the scene target of the same settings is read, the display target is written
+        void apply(PostSettings const &settings, glm::ivec2 viewport);
+
+        // for ShaderReloader
+        std::vector<ShaderProgram *> getShaders() noexcept;
+
+        RenderTarget const &getDisplay(PostSettings const &settings) const noexcept;
+        // what imgui should sample, valid after apply()
+        unsigned getDisplayTexture(PostSettings const &settings) const noexcept;
+        // every target the settings need, allocated at size
+        size_t getFootprint(PostSettings const &settings, glm::ivec2 size) const noexcept;
+    };
+
+    struct PostBenchmark {
+        PostSettings settings;
+        glm::ivec2 size;
+        double milliseconds;    // per apply
+    };
+    // times apply() for every combination, clobbers the targets. the caller has to prepare them again before drawing
+    std::vector<PostBenchmark> benchmarkPost(PostProcess &post, std::vector<PostSettings> const &settings, std::vector<glm::ivec2> const &sizes, unsigned iterations = 32);
+} // namespace ogl
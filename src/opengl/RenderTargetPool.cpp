@@ -0,0 +1,172 @@
+#include "RenderTargetPool.hpp"
+#include "StateCache.hpp"
+#include <cassert>
+#include <algorithm>
+
+size_t ogl::getAttachmentBytes(AttachmentDesc const &desc, glm::ivec2 size) noexcept
+{
+    size_t texelSize = 4;
+    switch (desc.internalFormat)
+    {
+    case GL_RGBA32F:           texelSize = 16; break;
+    case GL_RGBA16F:           texelSize = 8;  break;
+    case GL_RG16F:             texelSize = 4;  break;
+    case GL_DEPTH32F_STENCIL8: texelSize = 8;  break;
+    default:                   texelSize = 4;  break;  // rgba8, srgb8_alpha8, r11f_g11f_b10f, depth24_stencil8
+    }
+    return size_t(size.x) * size.y * texelSize * std::max(desc.samples, 1u);
+}
+
+size_t ogl::getTargetBytes(RenderTarget const &target, glm::ivec2 size) noexcept
+{
+    size_t bytes = 0;
+    for(AttachmentDesc const &desc : target.getAttachmentDescs()) bytes += getAttachmentBytes(desc, size);
+    return bytes;
+}
+
+ogl::RenderTargetPool::RenderTargetPool(size_t maxFreeBytes) : m_maxFreeBytes(maxFreeBytes) {}
+ogl::RenderTargetPool::~RenderTargetPool()
+{
+    trim();
+    for(std::unique_ptr<RenderTarget> const &target : m_targets) {
+        for(size_t i = 0; i < target->m_attachments.size(); ++i) {
+            if(target->m_attachments[i]) deleteAttachment(target->m_descs[i], target->m_attachments[i]);
+        }
+    }
+}
+
+ogl::RenderTarget &ogl::RenderTargetPool::createTarget(std::vector<AttachmentDesc> const &attachments)
+{
+    RenderTarget &target = *m_targets.emplace_back(std::make_unique<RenderTarget>());
+    target.m_framebuffer = Framebuffer{0}; // dummy argument
+    target.m_descs = attachments;
+    target.m_attachments.assign(attachments.size(), 0);
+    return target;
+}
+
+bool ogl::RenderTargetPool::resize(RenderTarget &target, glm::ivec2 viewport)
+{
+    viewport = glm::max(viewport, glm::ivec2{1});
+    target.m_viewport = viewport;
+    int bucketSize = std::max(m_policy.bucketSize, 1);
+    glm::ivec2 bucket = (viewport + bucketSize - 1) / bucketSize * bucketSize;
+
+    if(glm::any(glm::greaterThan(viewport, target.m_size))) {
+        // grow right away, the other axis only shrinks through the delay below
+        reallocate(target, glm::max(bucket, target.m_size));
+        return true;
+    }
+    if(bucket == target.m_size) {
+        target.m_shrinkRequested.reset();
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if(!target.m_shrinkRequested) target.m_shrinkRequested = now;
+    if(std::chrono::duration<double>(now - *target.m_shrinkRequested).count() < m_policy.shrinkDelay) return false;
+    reallocate(target, bucket);
+    return true;
+}
+
+void ogl::RenderTargetPool::reallocate(RenderTarget &target, glm::ivec2 size)
+{
+    target.m_shrinkRequested.reset();
+    for(size_t i = 0; i < target.m_descs.size(); ++i) {
+        AttachmentDesc const &desc = target.m_descs[i];
+        if(target.m_attachments[i]) releaseAttachment(desc, target.m_size, target.m_attachments[i]);
+        unsigned name = target.m_attachments[i] = acquireAttachment(desc, size);
+        if(desc.renderbuffer) {
+            glNamedFramebufferRenderbuffer(target.m_framebuffer.getRenderID(), desc.attachment, GL_RENDERBUFFER, name);
+        } else {
+            glNamedFramebufferTexture(target.m_framebuffer.getRenderID(), desc.attachment, name, 0);
+        }
+    }
+    target.m_size = size;
+    ++m_stats.numReconfigurations;
+    assert(target.m_framebuffer.isComplete());
+}
+
+bool ogl::RenderTargetPool::release(RenderTarget &target)
+{
+    if(target.m_size == glm::ivec2{0}) return false;
+    for(size_t i = 0; i < target.m_descs.size(); ++i) {
+        AttachmentDesc const &desc = target.m_descs[i];
+        if(desc.renderbuffer) {
+            glNamedFramebufferRenderbuffer(target.m_framebuffer.getRenderID(), desc.attachment, GL_RENDERBUFFER, 0);
+        } else {
+            glNamedFramebufferTexture(target.m_framebuffer.getRenderID(), desc.attachment, 0, 0);
+        }
+        releaseAttachment(desc, target.m_size, target.m_attachments[i]);
+        target.m_attachments[i] = 0;
+    }
+    target.m_size = glm::ivec2{0};
+    target.m_viewport = glm::ivec2{0};
+    target.m_shrinkRequested.reset();
+    return true;
+}
+
+void ogl::RenderTargetPool::trim()
+{
+    for(FreeAttachment const &attachment : m_free) {
+        deleteAttachment(attachment.desc, attachment.name);
+    }
+    m_free.clear();
+    m_stats.freeBytes = 0;
+}
+
+unsigned ogl::RenderTargetPool::acquireAttachment(AttachmentDesc const &desc, glm::ivec2 size)
+{
+    size_t bytes = getAttachmentBytes(desc, size);
+    // most recently released first, it is the likeliest to be resized back to
+    for(size_t i = m_free.size(); i-- > 0;) {
+        if(m_free[i].size != size || !m_free[i].desc.isCompatible(desc)) continue;
+        unsigned name = m_free[i].name;
+        m_free.erase(m_free.begin() + i);
+        m_stats.freeBytes -= bytes;
+        m_stats.usedBytes += bytes;
+        ++m_stats.numReused;
+        return name;
+    }
+
+    unsigned name = 0;
+    if(desc.renderbuffer) {
+        glCreateRenderbuffers(1, &name);
+        if(desc.samples) glNamedRenderbufferStorageMultisample(name, desc.samples, desc.internalFormat, size.x, size.y);
+        else glNamedRenderbufferStorage(name, desc.internalFormat, size.x, size.y);
+    } else if(desc.samples) {
+        glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &name);
+        glTextureStorage2DMultisample(name, desc.samples, desc.internalFormat, size.x, size.y, GL_TRUE);
+    } else {
+        glCreateTextures(GL_TEXTURE_2D, 1, &name);
+        glTextureStorage2D(name, 1, desc.internalFormat, size.x, size.y);
+        glTextureParameteri(name, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(name, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(name, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(name, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    m_stats.usedBytes += bytes;
+    ++m_stats.numCreated;
+    return name;
+}
+
+void ogl::RenderTargetPool::releaseAttachment(AttachmentDesc const &desc, glm::ivec2 size, unsigned name)
+{
+    size_t bytes = getAttachmentBytes(desc, size);
+    m_stats.usedBytes -= bytes;
+    m_stats.freeBytes += bytes;
+    m_free.push_back({desc, size, name});
+    while(m_stats.freeBytes > m_maxFreeBytes && !m_free.empty()) {
+        m_stats.freeBytes -= getAttachmentBytes(m_free.front().desc, m_free.front().size);
+        deleteAttachment(m_free.front().desc, m_free.front().name);
+        m_free.erase(m_free.begin());
+    }
+}
+
+void ogl::RenderTargetPool::deleteAttachment(AttachmentDesc const &desc, unsigned name)
+{
+    if(desc.renderbuffer) glDeleteRenderbuffers(1, &name);
+    else {
+        getStateCache().forgetTexture(name);
+        glDeleteTextures(1, &name);
+    }
+}
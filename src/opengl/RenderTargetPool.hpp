@@ -0,0 +1,108 @@
+#pragma once
+#include "Framebuffer.hpp"
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <optional>
+#include <cstddef>
+
+namespace ogl
+{
+    struct AttachmentDesc {
+        GLenum attachment = GL_COLOR_ATTACHMENT0;
+        GLenum internalFormat = GL_RGBA16F;
+        unsigned samples = 0;           // 0 for a single sampled attachment
+        bool renderbuffer = false;      // can't be sampled, fine for depth
+
+        inline bool isCompatible(AttachmentDesc const &other) const noexcept
+        {
+            return internalFormat == other.internalFormat && samples == other.samples && renderbuffer == other.renderbuffer;
+        }
+    };
+
+    class RenderTarget
+    {
+        friend class RenderTargetPool;
+    private:
+        Framebuffer m_framebuffer;
+        glm::ivec2 m_size{0};           // allocated
+        glm::ivec2 m_viewport{0};       // in use, from the origin
+        std::optional<std::chrono::steady_clock::time_point> m_shrinkRequested;
+        std::vector<AttachmentDesc> m_descs;
+        std::vector<unsigned> m_attachments;    // texture or renderbuffer names, same order as m_descs
+    public:
+        inline void bind() const noexcept { m_framebuffer.bind(); }
+        inline Framebuffer const &getFramebuffer() const noexcept { return m_framebuffer; }
+        inline glm::ivec2 getSize() const noexcept { return m_size; }
+        inline glm::ivec2 getViewport() const noexcept { return m_viewport; }
+        // corner of the viewport in texture coordinates
+        inline glm::vec2 getViewportUV() const noexcept { return glm::vec2{m_viewport} / glm::vec2{glm::max(m_size, glm::ivec2{1})}; }
+        inline unsigned getAttachment(unsigned index) const { return m_attachments.at(index); }
+        inline std::vector<AttachmentDesc> const &getAttachmentDescs() const noexcept { return m_descs; }
+    };
+
+    /*
+    owns render targets and their attachments. a target is declared once and resize() only touches gl when the allocation changes:
+    the old attachments go to a free list, new ones are taken from it when a compatible one of the right size is there,
+    the framebuffer is reattached and checked for completeness once. steady state frames do no framebuffer work at all.
+    targets are allocated in size buckets and rendered into a viewport from the origin, they grow right away
+    and only shrink after the viewport stayed in a smaller bucket for a while.
+    */
+    class RenderTargetPool
+    {
+    public:
+        struct ResizePolicy {
+            int bucketSize = 128;       // allocations round up to multiples of this many texels
+            double shrinkDelay = 1.0;   // seconds
+        };
+        struct Stats {
+            unsigned numCreated = 0;            // attachments allocated
+            unsigned numReused = 0;             // attachments taken from the free list
+            unsigned numReconfigurations = 0;   // framebuffer reattachments
+            size_t usedBytes = 0;
+            size_t freeBytes = 0;
+        };
+    private:
+        struct FreeAttachment {
+            AttachmentDesc desc;
+            glm::ivec2 size;
+            unsigned name;
+        };
+        std::vector<std::unique_ptr<RenderTarget>> m_targets;
+        std::vector<FreeAttachment> m_free;    // least recently released first
+        size_t m_maxFreeBytes;
+        ResizePolicy m_policy;
+        Stats m_stats;
+
+        void reallocate(RenderTarget &target, glm::ivec2 size);
+
+        unsigned acquireAttachment(AttachmentDesc const &desc, glm::ivec2 size);
+        void releaseAttachment(AttachmentDesc const &desc, glm::ivec2 size, unsigned name);
+        void deleteAttachment(AttachmentDesc const &desc, unsigned name);
+    public:
+        // unused attachments beyond maxFreeBytes are deleted, oldest first
+        explicit RenderTargetPool(size_t maxFreeBytes = size_t(256) << 20);
+        ~RenderTargetPool();
+        RenderTargetPool(RenderTargetPool const &) = delete;
+        RenderTargetPool &operator=(RenderTargetPool const &) = delete;
+
+        // the reference stays valid for the lifetime of the pool. attachments are allocated on the first resize
+        RenderTarget &createTarget(std::vector<AttachmentDesc> const &attachments);
+        // sets the viewport, returns true when the target had to be reallocated
+        bool resize(RenderTarget &target, glm::ivec2 viewport);
+        // give the attachments back to the free list until the next resize, returns false when there was nothing to release
+        bool release(RenderTarget &target);
+        // delete every unused attachment
+        void trim();
+
+        inline Stats const &getStats() const noexcept { return m_stats; }
+        inline ResizePolicy const &getResizePolicy() const noexcept { return m_policy; }
+        inline void setResizePolicy(ResizePolicy const &policy) noexcept { m_policy = policy; }
+    };
+
+    size_t getAttachmentBytes(AttachmentDesc const &desc, glm::ivec2 size) noexcept;
+    // what the target would take allocated at size
+    size_t getTargetBytes(RenderTarget const &target, glm::ivec2 size) noexcept;
+} // namespace ogl
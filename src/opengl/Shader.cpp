@@ -1,14 +1,151 @@
 #include "Shader.hpp"
+#include "StateCache.hpp"
 #include <fstream>
 #include <cassert>
 #include <filesystem>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
 
-bool compileShader(ogl::ShaderProgram::Shader &shader, std::string &log) noexcept {
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace
+{
+    std::filesystem::path binaryCacheDirectory;
+    ogl::ProgramBinaryCacheStats binaryCacheStats;
+    constexpr char BINARY_MAGIC[4] = { 'F', 'C', 'P', 'B' };
+
+    bool isProgramBinarySupported()
+    {
+        static GLint numFormats = -1;
+        if(numFormats < 0) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        return numFormats > 0;
+    }
+
+    // GL_COMPLETION_STATUS_KHR can be polled, the driver compiles and links on its own threads
+    bool isParallelCompileSupported()
+    {
+        static int supported = -1;
+        if(supported < 0) {
+            supported = 0;
+            GLint numExtensions = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+            for(GLint i = 0; i < numExtensions; ++i) {
+                std::string_view name = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, i));
+                if(name == "GL_KHR_parallel_shader_compile" || name == "GL_ARB_parallel_shader_compile") supported = 1;
+            }
+        }
+        return supported;
+    }
+
+    std::filesystem::path getBinaryPath(std::string const &directory, std::vector<ogl::ShaderProgram::Shader> const &shaders, ogl::ShaderProgram::Defines const &defines)
+    {
+        std::string key;
+        for(GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            char const *value = reinterpret_cast<char const *>(glGetString(name));
+            key += (value ? value : "") + std::string{"\n"};
+        }
+        // directory iteration order is unspecified
+        std::vector<ogl::ShaderProgram::Shader const *> sorted;
+        for(ogl::ShaderProgram::Shader const &shader : shaders) sorted.push_back(&shader);
+        std::sort(sorted.begin(), sorted.end(), [](auto const *a, auto const *b) { return a->type != b->type ? a->type < b->type : a->source < b->source; });
+        for(ogl::ShaderProgram::Shader const *shader : sorted) {
+            key += std::to_string(shader->type) + "\n" + shader->source + '\0';
+        }
+        for(auto const &[name, value] : defines) key += name + "=" + value + "\n";
+
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(ogl::hashName(key)));
+        std::string name = std::filesystem::path{directory}.filename().string();
+        if(name.empty()) name = std::filesystem::path{directory}.parent_path().filename().string();
+        return binaryCacheDirectory / (name + "-" + hash + ".bin");
+    }
+
+    bool loadProgramBinary(unsigned &program, std::filesystem::path const &path) noexcept
+    {
+        std::ifstream file{path, std::ios::binary};
+        if(!file) return false;
+        std::vector<char> contents{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        constexpr size_t headerSize = sizeof(BINARY_MAGIC) + 2 * sizeof(uint32_t);
+        if(contents.size() < headerSize || std::memcmp(contents.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) return false;
+        uint32_t format = 0, length = 0;
+        std::memcpy(&format, contents.data() + sizeof(BINARY_MAGIC), sizeof(format));
+        std::memcpy(&length, contents.data() + sizeof(BINARY_MAGIC) + sizeof(format), sizeof(length));
+        if(contents.size() != headerSize + length) return false;
+
+        program = glCreateProgram();
+        glProgramBinary(program, format, contents.data() + headerSize, GLsizei(length));
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if(!success) {
+            // driver update or a format it dropped, compile from source
+            glDeleteProgram(program);
+            program = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void saveProgramBinary(unsigned program, std::filesystem::path const &path) noexcept
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(length <= 0) return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        // written aside and renamed, a crash mid write must not leave a truncated binary behind
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream file{temporary, std::ios::binary};
+            uint32_t const header[] = { format, uint32_t(length) };
+            file.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+            file.write(reinterpret_cast<char const *>(header), sizeof(header));
+            file.write(binary.data(), length);
+            if(!file) return;
+        }
+        std::filesystem::rename(temporary, path, error);
+    }
+} // namespace
+
+void ogl::setProgramBinaryCache(std::filesystem::path const &directory) { binaryCacheDirectory = directory; }
+std::filesystem::path const &ogl::getProgramBinaryCache() noexcept { return binaryCacheDirectory; }
+ogl::ProgramBinaryCacheStats const &ogl::getProgramBinaryCacheStats() noexcept { return binaryCacheStats; }
+
+std::string insertDefines(std::string const &source, ogl::ShaderProgram::Defines const &defines)
+{
+    if(defines.empty()) return source;
+    std::string lines;
+    for(auto const &[name, value] : defines) {
+        lines += "#define " + name + " " + value + "\n";
+    }
+    size_t version = source.find("#version");
+    size_t position = version == std::string::npos ? 0 : source.find('\n', version);
+    if(position == std::string::npos) return source + "\n" + lines;
+    if(version != std::string::npos) ++position;
+    // keep compiler messages pointing at the lines in the file
+    lines += "#line " + std::to_string(std::count(source.begin(), source.begin() + position, '\n') + 1) + "\n";
+    return source.substr(0, position) + lines + source.substr(position);
+}
+
+// compile and link only queue the work, the status queries are what block
+void startShader(ogl::ShaderProgram::Shader &shader, ogl::ShaderProgram::Defines const &defines) noexcept {
     shader.renderID = glCreateShader(shader.type);
-    char *source = &*shader.source.begin();
+    std::string fullSource = insertDefines(shader.source, defines);
+    char const *source = fullSource.c_str();
     glShaderSource(shader.renderID, 1, &source, nullptr);
     glCompileShader(shader.renderID);
+}
+bool checkShader(ogl::ShaderProgram::Shader const &shader, std::string &log) noexcept {
     int success;
     glGetShaderiv(shader.renderID, GL_COMPILE_STATUS, &success);
     if(!success) {
@@ -16,20 +153,24 @@ bool compileShader(ogl::ShaderProgram::Shader &shader, std::string &log) noexcep
         glGetShaderiv(shader.renderID, GL_INFO_LOG_LENGTH, &log_size);
         if(log_size > 0) {
             log.resize(log_size);
-            glGetShaderInfoLog(shader.renderID, log_size, nullptr, &log[0]);
+            GLsizei length = 0;
+            glGetShaderInfoLog(shader.renderID, log_size, &length, &log[0]);
+            log.resize(length); // without the terminator, more lines get appended
         }
         return false;
     }
     return true;
 }
 
-bool linkProgram(unsigned &program, std::vector<ogl::ShaderProgram::Shader> shaders, std::string &log) noexcept {
+void startLink(unsigned &program, std::vector<ogl::ShaderProgram::Shader> const &shaders, bool retrievable) noexcept {
     program = glCreateProgram();
     for(auto const &shader : shaders) {
         glAttachShader(program, shader.renderID);
     }
+    if(retrievable) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program);
-
+}
+bool checkLink(unsigned program, std::string &log) noexcept {
     int success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if(!success) {
@@ -37,22 +178,35 @@ bool linkProgram(unsigned &program, std::vector<ogl::ShaderProgram::Shader> shad
         glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_size);
         if(log_size > 0) {
             log.resize(log_size);
-            glGetProgramInfoLog(program, log_size, nullptr, &log[0]);
+            GLsizei length = 0;
+            glGetProgramInfoLog(program, log_size, &length, &log[0]);
+            log.resize(length); // without the terminator, more lines get appended
         }
         return false;
     }
     return true;
 }
 
-void ogl::ShaderProgram::deallocate() noexcept
+void deleteProgram(unsigned program, std::vector<ogl::ShaderProgram::Shader> &shaders) noexcept
 {
-    if(m_renderID) glDeleteProgram(m_renderID);
-    for(Shader const &shader : m_shaders) {
+    if(program) {
+        ogl::getStateCache().forgetProgram(program);
+        glDeleteProgram(program);
+    }
+    for(ogl::ShaderProgram::Shader &shader : shaders) {
         if(shader.renderID) glDeleteShader(shader.renderID);
-    }   
+        shader.renderID = 0;
+    }
+}
+
+void ogl::ShaderProgram::deallocate() noexcept
+{
+    deleteProgram(m_renderID, m_shaders);
+    deleteProgram(m_pending.program, m_pending.shaders);
+    m_pending = {};
 }
 
-ogl::ShaderProgram::ShaderProgram(std::string const &directory, bool showLog)
+ogl::ShaderProgram::ShaderProgram(std::string const &directory, bool showLog, Defines const &defines) : m_defines(defines)
 {
     if(!collectShaders(directory)) {
         m_log.insert(0, "failed to collect shaders in directory \"" + directory + "\"\n");
@@ -73,35 +227,147 @@ ogl::ShaderProgram::~ShaderProgram()
     }
 }
 
-bool ogl::ShaderProgram::collectShaders(std::string const &directory) noexcept
+namespace
 {
-    assert(std::filesystem::exists(directory));
-    m_dirPath = directory;
-    m_log = "";
-    m_shaders.erase(m_shaders.begin(), m_shaders.end());
-    m_uniformLocationCache.erase(m_uniformLocationCache.begin(), m_uniformLocationCache.end());
-    for(auto const &directoryEntry : std::filesystem::recursive_directory_iterator{directory}) {
-        if(!std::filesystem::is_regular_file(directoryEntry.path())) continue; 
-        Shader shader;
+    // a file split at its #include lines, parsed once and reused until its modification time changes
+    struct SourceFile {
+        struct Include {
+            size_t begin, end;  // the directive line including its newline
+            unsigned line;      // 1 based
+            std::string name;
+        };
+        std::filesystem::file_time_type time;
+        std::string text;
+        std::vector<Include> includes;
+    };
+    std::map<std::filesystem::path, SourceFile> sourceFiles;
 
-        std::string extension = directoryEntry.path().string().substr(directoryEntry.path().string().find_last_of('.'), directoryEntry.path().string().size());
+    SourceFile const *loadSourceFile(std::filesystem::path const &path)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+        if(error) return nullptr;
+        auto cached = sourceFiles.find(path);
+        if(cached != sourceFiles.end() && cached->second.time == time) return &cached->second;
+
+        std::ifstream filestream{path};
+        if(!filestream) return nullptr;
+        SourceFile file{time, std::string{std::istreambuf_iterator<char>{filestream}, std::istreambuf_iterator<char>{}}, {}};
+        unsigned line = 1;
+        for(size_t begin = 0; begin < file.text.size(); ++line) {
+            size_t end = file.text.find('\n', begin);
+            end = end == std::string::npos ? file.text.size() : end + 1;
+            std::string_view text = std::string_view{file.text}.substr(begin, end - begin);
+            // #include "name", whitespace allowed around the #
+            size_t hash = text.find_first_not_of(" \t");
+            if(hash != std::string_view::npos && text[hash] == '#') {
+                size_t keyword = text.find_first_not_of(" \t", hash + 1);
+                size_t open = keyword == std::string_view::npos ? keyword : text.find('"', keyword);
+                size_t close = open == std::string_view::npos ? open : text.find('"', open + 1);
+                if(close != std::string_view::npos && text.substr(keyword, 7) == "include") {
+                    file.includes.push_back({begin, end, line, std::string{text.substr(open + 1, close - open - 1)}});
+                }
+            }
+            begin = end;
+        }
+        return &(sourceFiles[path] = std::move(file));
+    }
+
+    /*
+    pastes included files in place, each once per shader. #line directives keep compiler messages pointing at the
+    right line, the source string number is the index in files
+    */
+    bool expandIncludes(std::filesystem::path const &path, std::string &source, std::vector<std::filesystem::path> &files, std::string &log)
+    {
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+        files.push_back(canonical);
+        unsigned index = unsigned(files.size() - 1);
+        SourceFile const *file = loadSourceFile(canonical);
+        if(!file) {
+            log.append("failed to read \"" + path.string() + "\"\n");
+            return false;
+        }
+        size_t position = 0;
+        for(SourceFile::Include const &include : file->includes) {
+            source.append(file->text, position, include.begin - position);
+            position = include.end;
+            // relative to the including file, shared files live in shaders/include
+            std::filesystem::path included = std::filesystem::weakly_canonical(canonical.parent_path() / include.name, error);
+            if(std::find(files.begin(), files.end(), included) != files.end()) {
+                source += "\n";
+                continue;
+            }
+            source += "#line 1 " + std::to_string(files.size()) + "\n";
+            if(!expandIncludes(included, source, files, log)) {
+                log.append(path.string() + ":" + std::to_string(include.line) + ": included from here\n");
+                return false;
+            }
+            source += "\n#line " + std::to_string(include.line + 1) + " " + std::to_string(index) + "\n";
+        }
+        source.append(file->text, position);
+        return true;
+    }
+
+    std::vector<std::filesystem::path> collectDependencies(std::vector<ogl::ShaderProgram::Shader> const &shaders)
+    {
+        std::vector<std::filesystem::path> dependencies;
+        for(ogl::ShaderProgram::Shader const &shader : shaders) {
+            dependencies.insert(dependencies.end(), shader.files.begin(), shader.files.end());
+        }
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        return dependencies;
+    }
+} // namespace
+
+bool collectShaderFiles(std::string const &directory, std::vector<ogl::ShaderProgram::Shader> &shaders, std::string &log) noexcept
+{
+    // files can disappear while an editor saves, error codes instead of exceptions
+    std::error_code error;
+    std::filesystem::recursive_directory_iterator iterator{directory, error};
+    if(error) return false;
+    for(; iterator != std::filesystem::recursive_directory_iterator{}; iterator.increment(error)) {
+        if(error) return false;
+        std::filesystem::path const &path = iterator->path();
+        if(!std::filesystem::is_regular_file(path, error)) continue; 
+        ogl::ShaderProgram::Shader shader;
+
+        // shaders are named by type alone (.vert), which has no extension() as far as std::filesystem goes.
+        // name.ext files use the extension, anything else, like the probe files editors write while saving, is skipped
+        std::string extension = path.extension().string();
+        if(extension.empty()) extension = path.filename().string();
         if(extension == ".vert") shader.type = GL_VERTEX_SHADER;
         else if(extension == ".geom") shader.type = GL_GEOMETRY_SHADER;
         else if(extension == ".frag") shader.type = GL_FRAGMENT_SHADER;
         else if(extension == ".comp") shader.type = GL_COMPUTE_SHADER;
         else {
-            m_log.append("unrecognised shader extension: \"" + directoryEntry.path().extension().string() + "\"\n");
-            // return false;
+            log.append("unrecognised shader extension: \"" + extension + "\"\n");
             continue;
         }
 
-        std::ifstream filestream{directoryEntry.path()};
-        shader.source = std::string{std::istreambuf_iterator<char>{filestream}, std::istreambuf_iterator<char>{}};
-        m_shaders.emplace_back(std::move(shader));
+        bool expanded = expandIncludes(path, shader.source, shader.files, log);
+        shaders.emplace_back(std::move(shader));
+        if(!expanded) return false;
+    }
+    if(shaders.empty()) {
+        log.append("no shaders in \"" + directory + "\"\n");
+        return false;
     }
     return true;
 }
 
+bool ogl::ShaderProgram::collectShaders(std::string const &directory) noexcept
+{
+    assert(std::filesystem::exists(directory));
+    m_dirPath = directory;
+    m_log = "";
+    m_shaders.clear();
+    bool collected = collectShaderFiles(directory, m_shaders, m_log);
+    m_dependencies = collectDependencies(m_shaders);
+    return collected;
+}
+
 std::string shaderTypeToString(unsigned type) noexcept {
     switch (type)
     {
@@ -114,36 +380,143 @@ std::string shaderTypeToString(unsigned type) noexcept {
 }
 bool ogl::ShaderProgram::compileShaders() noexcept
 {
-    if(canDeallocate()) 
-        deallocate();
+    startCompile(m_shaders);
+    return finishCompile();
+}
 
-    m_uniformLocationCache.erase(m_uniformLocationCache.begin(), m_uniformLocationCache.end());
-    m_log = "";
-    
-    for(Shader &shader : m_shaders) {
-        if(!compileShader(shader, m_log)) {
-            m_log.insert(0, "failed to compile " + shaderTypeToString(shader.type) + " shader\n");
-            return false;
+bool ogl::ShaderProgram::beginCompile() noexcept
+{
+    std::vector<Shader> shaders;
+    std::string log;
+    bool collected = collectShaderFiles(m_dirPath, shaders, log);
+    // also after a failure, the fix can be in a file that was only just included
+    m_dependencies = collectDependencies(shaders);
+    if(!collected) {
+        m_log = "failed to collect shaders in directory \"" + m_dirPath + "\"\n" + log;
+        return false;
+    }
+    startCompile(std::move(shaders));
+    return true;
+}
+
+void ogl::ShaderProgram::startCompile(std::vector<Shader> shaders) noexcept
+{
+    auto start = std::chrono::steady_clock::now();
+    deleteProgram(m_pending.program, m_pending.shaders);
+    m_pending = {};
+    m_pending.shaders = std::move(shaders);
+    for(Shader &shader : m_pending.shaders) shader.renderID = 0;
+
+    if(!binaryCacheDirectory.empty() && isProgramBinarySupported()) {
+        m_pending.binaryPath = getBinaryPath(m_dirPath, m_pending.shaders, m_defines);
+        if(loadProgramBinary(m_pending.program, m_pending.binaryPath)) {
+            m_pending.fromBinaryCache = true;
+            ++binaryCacheStats.hits;
+        } else {
+            ++binaryCacheStats.misses;
         }
     }
+    if(!m_pending.fromBinaryCache) {
+        for(Shader &shader : m_pending.shaders) startShader(shader, m_defines);
+        startLink(m_pending.program, m_pending.shaders, !m_pending.binaryPath.empty());
+    }
+    binaryCacheStats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
-    if(!linkProgram(m_renderID, m_shaders, m_log)) {
-        m_log.insert(0, "failed to link shader program\n");
-        return false;
+bool ogl::ShaderProgram::isCompileReady() const noexcept
+{
+    if(!m_pending.program || m_pending.fromBinaryCache || !isParallelCompileSupported()) return true;
+    GLint done = GL_TRUE;
+    glGetProgramiv(m_pending.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done;
+}
+
+bool ogl::ShaderProgram::finishCompile() noexcept
+{
+    if(!m_pending.program) return false;
+    auto start = std::chrono::steady_clock::now();
+    Pending pending = std::move(m_pending);
+    m_pending = {};
+
+    std::string log;
+    bool success = true;
+    if(!pending.fromBinaryCache) {
+        for(Shader const &shader : pending.shaders) {
+            if(!checkShader(shader, log)) {
+                log.insert(0, "failed to compile " + shaderTypeToString(shader.type) + " shader\n");
+                for(size_t i = 0; i < shader.files.size() && shader.files.size() > 1; ++i) {
+                    log.append("source " + std::to_string(i) + ": " + shader.files[i].string() + "\n");
+                }
+                success = false;
+                break;
+            }
+        }
+        if(success && !checkLink(pending.program, log)) {
+            log.insert(0, "failed to link shader program\n");
+            success = false;
+        }
+    }
+    m_log = log;
+    if(success) {
+        if(!pending.fromBinaryCache && !pending.binaryPath.empty()) saveProgramBinary(pending.program, pending.binaryPath);
+        // the program keeps what it needs, the shader objects only cost memory from here on
+        for(Shader &shader : pending.shaders) {
+            if(!shader.renderID) continue;
+            glDetachShader(pending.program, shader.renderID);
+            glDeleteShader(shader.renderID);
+            shader.renderID = 0;
+        }
+        if(canDeallocate()) 
+            deallocate();
+        m_renderID = pending.program;
+        m_shaders = std::move(pending.shaders);
+        m_fromBinaryCache = pending.fromBinaryCache;
+        reflectUniforms();
+    } else {
+        // the current program stays in use
+        deleteProgram(pending.program, pending.shaders);
     }
+    binaryCacheStats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return success;
+}
 
-    return true;
+void ogl::ShaderProgram::reflectUniforms()
+{
+    static uint64_t nextLinkID = 1;
+    m_linkID = nextLinkID++;
+    m_uniforms.clear();
+
+    GLint count = 0, maxNameLength = 0;
+    glGetProgramInterfaceiv(m_renderID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(m_renderID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+    std::string name(std::max(maxNameLength, 1), '\0');
+    GLenum const properties[] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+    for(GLint i = 0; i < count; ++i) {
+        GLint values[std::size(properties)];
+        glGetProgramResourceiv(m_renderID, GL_UNIFORM, i, GLsizei(std::size(properties)), properties, GLsizei(std::size(values)), nullptr, values);
+        if(values[3] != -1) continue; // block members have no location
+        GLsizei length = 0;
+        glGetProgramResourceName(m_renderID, GL_UNIFORM, i, GLsizei(name.size()), &length, name.data());
+        std::string uniformName = name.substr(0, length);
+        if(uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) uniformName.resize(uniformName.size() - 3);
+        m_uniforms.push_back({hashName(uniformName), values[0], GLenum(values[1]), values[2], std::move(uniformName)});
+    }
+    std::sort(m_uniforms.begin(), m_uniforms.end(), [](Uniform const &a, Uniform const &b) { return a.hash < b.hash; });
+    assert(std::adjacent_find(m_uniforms.begin(), m_uniforms.end(), [](Uniform const &a, Uniform const &b) { return a.hash == b.hash; }) == m_uniforms.end() && "uniform name hash collision");
+}
+
+int ogl::ShaderProgram::getUniform(uint64_t hash) const noexcept
+{
+    auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), hash, [](Uniform const &uniform, uint64_t hash) { return uniform.hash < hash; });
+    return it != m_uniforms.end() && it->hash == hash ? it->location : -1;
 }
 
 int ogl::ShaderProgram::getUniform(std::string const &name) const noexcept
 {
-    if(m_uniformLocationCache.find(name) != m_uniformLocationCache.end()) return m_uniformLocationCache[name];
-    int location = glGetUniformLocation(m_renderID, name.c_str());
-    m_uniformLocationCache[name] = location;
-    // if(location == -1) {
-    //     std::cout << "uniform \"" << name << "\" in shaders \"" << getPath() << "\" is not used or does not exist.\n";
-    // }
-    return location;
+    int location = getUniform(hashName(name));
+    // array elements other than the first are not in the table
+    if(location != -1 || name.find('[') == std::string::npos) return location;
+    return glGetUniformLocation(m_renderID, name.c_str());
 }
 
 int ogl::ShaderProgram::getUniformBlock(std::string const &name) const noexcept
@@ -158,4 +531,4 @@ int ogl::ShaderProgram::getStorageBlock(std::string const &name) const noexcept
     return location;
 }
 
-void ogl::ShaderProgram::bind(unsigned slot) const noexcept { glUseProgram(m_renderID); }
+void ogl::ShaderProgram::bind(unsigned slot) const noexcept { getStateCache().useProgram(m_renderID); }
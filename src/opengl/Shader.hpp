@@ -4,30 +4,109 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <string_view>
+#include <filesystem>
+#include <cstdint>
 
 namespace ogl
 {
+    // fnv-1a, constexpr so uniform names are hashed at compile time
+    constexpr uint64_t hashName(std::string_view name) noexcept
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for(char c : name) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /*
+    a uniform name hashed once, resolved against a program on first use and cached until the program is relinked.
+    keep one per program and uniform next to the program, e.g. as a member, so updates are a single compare.
+    */
+    class UniformHandle {
+        friend class ShaderProgram;
+    private:
+        uint64_t m_hash;
+        char const *m_name;
+        mutable uint64_t m_linkID = 0;
+        mutable int m_location = -1;
+    public:
+        constexpr explicit UniformHandle(char const *name) noexcept : m_hash(hashName(name)), m_name(name) {}
+        constexpr uint64_t getHash() const noexcept { return m_hash; }
+        constexpr char const *getName() const noexcept { return m_name; }
+    };
+
     class ShaderProgram : public Object {
     public:
+        // compile time constants, inserted as #define NAME VALUE right after the #version line
+        using Defines = std::map<std::string, std::string>;
         struct Shader {
             unsigned renderID = 0;
             GLenum type;
-            std::string source;
+            std::string source;                         // with #include lines expanded
+            std::vector<std::filesystem::path> files;   // canonical, the shader file then its includes. the #line source numbers
+        };
+        // a compile that was started but not yet checked, see beginCompile()
+        struct Pending {
+            unsigned program = 0;
+            std::vector<Shader> shaders;
+            std::filesystem::path binaryPath;
+            bool fromBinaryCache = false;
+        };
+        // an active uniform outside of blocks, reflected at link time. arrays are listed without the [0]
+        struct Uniform {
+            uint64_t hash;
+            int location;
+            GLenum type;
+            int arraySize;
+            std::string name;
         };
     private:
-        mutable std::map<std::string, int> m_uniformLocationCache;
+        std::vector<Uniform> m_uniforms;    // sorted by hash
+        uint64_t m_linkID = 0;              // unique per successful link, invalidates UniformHandle caches
         std::vector<Shader> m_shaders;
         std::string m_log;
         std::string m_dirPath;
+        Defines m_defines;
+        bool m_fromBinaryCache = false;
+        Pending m_pending;
+        std::vector<std::filesystem::path> m_dependencies;  // sorted, every file of the last collected sources
         void deallocate() noexcept;
+        void reflectUniforms();
+        void startCompile(std::vector<Shader> shaders) noexcept;
         
         public:
         ShaderProgram() noexcept = default;
-        explicit ShaderProgram(std::string const &directory, bool showLog = true);
+        explicit ShaderProgram(std::string const &directory, bool showLog = true, Defines const &defines = {});
         ~ShaderProgram();
         bool collectShaders(std::string const &directory) noexcept;
+        // compiles the collected sources and waits. on failure the previous program stays in use and the log says why
         bool compileShaders() noexcept;
+        /*
+        the same from the files on disk without waiting for the driver. with GL_KHR_parallel_shader_compile the work
+        runs on driver threads until isCompileReady(), finishCompile() swaps the new program in only when it linked
+        */
+        bool beginCompile() noexcept;
+        bool isCompileReady() const noexcept;
+        bool finishCompile() noexcept;
+        inline bool isCompilePending() const noexcept { return m_pending.program != 0; }
+        // canonical path, e.g. an include shared with other programs
+        inline bool dependsOn(std::filesystem::path const &file) const noexcept { return std::binary_search(m_dependencies.begin(), m_dependencies.end(), file); }
+        inline std::vector<std::filesystem::path> const &getDependencies() const noexcept { return m_dependencies; }
         int getUniform(std::string const &name) const noexcept;
+        // -1 when the program has no such active uniform
+        int getUniform(uint64_t hash) const noexcept;
+        inline int getUniform(UniformHandle const &handle) const noexcept
+        {
+            if(handle.m_linkID != m_linkID) {
+                handle.m_location = getUniform(handle.m_hash);
+                handle.m_linkID = m_linkID;
+            }
+            return handle.m_location;
+        }
         int getUniformBlock(std::string const &name) const noexcept;
         int getStorageBlock(std::string const &name) const noexcept;
         void bind(unsigned slot = 0) const noexcept override;
@@ -37,5 +116,24 @@ namespace ogl
         inline std::string const &getPath() const noexcept { return m_dirPath; }
         inline std::string &getPath() noexcept { return m_dirPath; }
         inline std::string const &getLog() const noexcept { return m_log; }
+        inline std::vector<Uniform> const &getUniforms() const noexcept { return m_uniforms; }
+        inline Defines const &getDefines() const noexcept { return m_defines; }
+        inline Defines &getDefines() noexcept { return m_defines; }
+        // the last compileShaders() loaded a program binary instead of compiling
+        inline bool isFromBinaryCache() const noexcept { return m_fromBinaryCache; }
+    };
+
+    /*
+    program binary cache. linked programs are saved with glGetProgramBinary and loaded with glProgramBinary,
+    keyed by a hash of the sources with their includes, the defines and the driver vendor, renderer and version.
+    a binary the driver rejects falls back to compiling from source and gets replaced. an empty directory disables it
+    */
+    void setProgramBinaryCache(std::filesystem::path const &directory);
+    std::filesystem::path const &getProgramBinaryCache() noexcept;
+    struct ProgramBinaryCacheStats {
+        unsigned hits = 0;
+        unsigned misses = 0;
+        double seconds = 0;     // spent compiling or loading on the calling thread
     };
+    ProgramBinaryCacheStats const &getProgramBinaryCacheStats() noexcept;
 } // namespace ogl
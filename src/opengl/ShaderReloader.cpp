@@ -0,0 +1,189 @@
+#include "ShaderReloader.hpp"
+#include <algorithm>
+#include <map>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // editors save in several steps, a write, a rename, a chmod. compile once they are done
+    constexpr std::chrono::milliseconds SETTLE_TIME{50};
+    constexpr std::chrono::milliseconds STOP_CHECK_INTERVAL{100};
+    constexpr std::chrono::milliseconds POLL_INTERVAL{250};
+
+    // files come and go while the directory is walked, errors end the walk instead of throwing
+    template <typename Func_t>
+    void forEachEntry(std::filesystem::path const &directory, Func_t const &func)
+    {
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator iterator{directory, error};
+        for(; !error && iterator != std::filesystem::recursive_directory_iterator{}; iterator.increment(error)) {
+            func(*iterator);
+        }
+    }
+
+    bool isInside(std::filesystem::path const &file, std::filesystem::path const &directory)
+    {
+        return std::mismatch(directory.begin(), directory.end(), file.begin(), file.end()).first == directory.end();
+    }
+} // namespace
+
+ogl::ShaderReloader::ShaderReloader(std::filesystem::path directory, std::function<void()> onChange) :
+    m_directory(std::move(directory)),
+    m_onChange(std::move(onChange))
+{
+    m_thread = std::thread{&ShaderReloader::watch, this};
+}
+ogl::ShaderReloader::~ShaderReloader()
+{
+    m_stop = true;
+    m_thread.join();
+}
+
+void ogl::ShaderReloader::add(ShaderProgram &program)
+{
+    std::error_code error;
+    m_entries.push_back({&program, std::filesystem::weakly_canonical(program.getPath(), error)});
+    m_status.push_back({&program, {}});
+}
+
+void ogl::ShaderReloader::reloadAll() noexcept
+{
+    for(Entry &entry : m_entries) entry.dirty = true;
+}
+
+bool ogl::ShaderReloader::update()
+{
+    std::vector<std::filesystem::path> changed;
+    {
+        std::lock_guard lock{m_mutex};
+        if(!m_changed.empty() && std::chrono::steady_clock::now() - m_lastChange >= SETTLE_TIME) changed.swap(m_changed);
+    }
+    for(std::filesystem::path const &file : changed) {
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(file, error);
+        for(Entry &entry : m_entries) {
+            // new files in the program directory or anything in its include closure
+            if(isInside(canonical, entry.directory) || entry.program->dependsOn(canonical)) entry.dirty = true;
+        }
+    }
+
+    bool replaced = false;
+    for(size_t i = 0; i < m_entries.size(); ++i) {
+        ShaderProgram &program = *m_entries[i].program;
+        Status &status = m_status[i];
+        if(program.isCompilePending() && program.isCompileReady()) {
+            if(program.finishCompile()) {
+                status.log.clear();
+                ++status.reloads;
+                replaced = true;
+            } else {
+                status.log = program.getLog();
+            }
+        }
+        // a change during a compile starts another one after it
+        if(m_entries[i].dirty && !program.isCompilePending()) {
+            m_entries[i].dirty = false;
+            if(!program.beginCompile()) status.log = program.getLog();
+        }
+        status.compiling = program.isCompilePending();
+    }
+    return replaced;
+}
+
+bool ogl::ShaderReloader::isBusy()
+{
+    for(Entry const &entry : m_entries) {
+        if(entry.dirty || entry.program->isCompilePending()) return true;
+    }
+    std::lock_guard lock{m_mutex};
+    return !m_changed.empty();
+}
+
+void ogl::ShaderReloader::pushChanges(std::vector<std::filesystem::path> &changed)
+{
+    if(changed.empty()) return;
+    {
+        std::lock_guard lock{m_mutex};
+        m_changed.insert(m_changed.end(), changed.begin(), changed.end());
+        m_lastChange = std::chrono::steady_clock::now();
+    }
+    if(m_onChange) m_onChange();
+}
+
+void ogl::ShaderReloader::watch()
+{
+#ifdef __linux__
+    int inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify < 0) {
+        pollModificationTimes();
+        return;
+    }
+    std::map<int, std::filesystem::path> directories;
+    auto addWatch = [&](std::filesystem::path const &directory) {
+        int watch = inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+        if(watch >= 0) directories[watch] = directory;
+    };
+    // inotify is not recursive, every directory gets its own watch
+    addWatch(m_directory);
+    forEachEntry(m_directory, [&](std::filesystem::directory_entry const &entry) {
+        std::error_code error;
+        if(entry.is_directory(error)) addWatch(entry.path());
+    });
+
+    alignas(inotify_event) char buffer[4096];
+    while(!m_stop) {
+        pollfd descriptor{inotify, POLLIN, 0};
+        if(poll(&descriptor, 1, int(STOP_CHECK_INTERVAL.count())) <= 0) continue;
+        std::vector<std::filesystem::path> changed;
+        for(ssize_t size; (size = read(inotify, buffer, sizeof(buffer))) > 0;) {
+            for(char const *at = buffer; at < buffer + size;) {
+                inotify_event const *event = reinterpret_cast<inotify_event const *>(at);
+                at += sizeof(inotify_event) + event->len;
+                auto directory = directories.find(event->wd);
+                if(directory == directories.end() || event->len == 0) continue;
+                std::filesystem::path path = directory->second / event->name;
+                if((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) addWatch(path);
+                changed.push_back(std::move(path));
+            }
+        }
+        pushChanges(changed);
+    }
+    close(inotify);
+#else
+    pollModificationTimes();
+#endif
+}
+
+void ogl::ShaderReloader::pollModificationTimes()
+{
+    std::map<std::filesystem::path, std::filesystem::file_time_type> times;
+    auto scan = [&]() {
+        std::map<std::filesystem::path, std::filesystem::file_time_type> current;
+        forEachEntry(m_directory, [&](std::filesystem::directory_entry const &entry) {
+            std::error_code error;
+            std::filesystem::file_time_type time = entry.last_write_time(error);
+            if(!error) current[entry.path()] = time;
+        });
+        std::vector<std::filesystem::path> changed;
+        for(auto const &[path, time] : current) {
+            auto previous = times.find(path);
+            if(previous == times.end() || previous->second != time) changed.push_back(path);
+        }
+        for(auto const &[path, time] : times) {
+            if(current.find(path) == current.end()) changed.push_back(path);
+        }
+        times = std::move(current);
+        return changed;
+    };
+    scan();
+    while(!m_stop) {
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        std::vector<std::filesystem::path> changed = scan();
+        pushChanges(changed);
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Shader.hpp"
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+namespace ogl
+{
+    /*
+    recompiles the added programs when files under a directory change.
+    a background thread waits on inotify (polls modification times where that is missing) and only records the changes,
+    compiles are started and swapped in on the gl thread from update(). a program that fails keeps the previous version
+    */
+    class ShaderReloader
+    {
+    public:
+        struct Status {
+            ShaderProgram const *program;
+            std::string log;            // of the last failed compile, empty after a successful one
+            unsigned reloads = 0;
+            bool compiling = false;
+        };
+    private:
+        struct Entry {
+            ShaderProgram *program;
+            std::filesystem::path directory;    // canonical
+            bool dirty = false;
+        };
+        std::filesystem::path m_directory;
+        std::function<void()> m_onChange;
+        std::vector<Entry> m_entries;
+        std::vector<Status> m_status;           // parallel to m_entries
+
+        std::mutex m_mutex;
+        std::vector<std::filesystem::path> m_changed;           // guarded by m_mutex
+        std::chrono::steady_clock::time_point m_lastChange;     // guarded by m_mutex
+        std::atomic_bool m_stop = false;
+        std::thread m_thread;
+
+        void pushChanges(std::vector<std::filesystem::path> &changed);
+        void watch();
+        void pollModificationTimes();
+    public:
+        // onChange is called from the watcher thread, e.g. glfwPostEmptyEvent to wake a waiting main loop
+        explicit ShaderReloader(std::filesystem::path directory, std::function<void()> onChange = {});
+        ~ShaderReloader();
+        ShaderReloader(ShaderReloader const &) = delete;
+        ShaderReloader &operator=(ShaderReloader const &) = delete;
+
+        // the program has to outlive the reloader
+        void add(ShaderProgram &program);
+        void reloadAll() noexcept;
+        // returns true when a program was replaced and whatever it drew is stale
+        bool update();
+        // compiles in flight or changes waiting for the editor to finish writing
+        bool isBusy();
+
+        inline std::vector<Status> const &getStatus() const noexcept { return m_status; }
+    };
+} // namespace ogl
@@ -3,7 +3,7 @@
 
 ogl::UniformBuffer::UniformBuffer(int) noexcept
 {
-    glGenBuffers(1, &m_renderID);
+    glCreateBuffers(1, &m_renderID);
 }
 
 ogl::UniformBuffer::~UniformBuffer()
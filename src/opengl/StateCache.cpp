@@ -0,0 +1,77 @@
+#include "StateCache.hpp"
+#include <algorithm>
+
+ogl::StateCache &ogl::getStateCache() noexcept
+{
+    static StateCache cache;
+    return cache;
+}
+
+void ogl::StateCache::bindTextureUnit(unsigned unit, unsigned texture) noexcept
+{
+    if(unit >= MAX_TEXTURE_UNITS) {
+        ++m_counters.issued;
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+    if(update(m_textures[unit], texture)) glBindTextureUnit(unit, texture);
+}
+
+void ogl::StateCache::setEnabled(GLenum capability, bool enabled) noexcept
+{
+    unsigned *shadow = nullptr;
+    switch(capability) {
+        case GL_DEPTH_TEST:         shadow = &m_capabilities[DEPTH_TEST]; break;
+        case GL_CULL_FACE:          shadow = &m_capabilities[CULL_FACE]; break;
+        case GL_BLEND:              shadow = &m_capabilities[BLEND]; break;
+        case GL_FRAMEBUFFER_SRGB:   shadow = &m_capabilities[FRAMEBUFFER_SRGB]; break;
+        default: ++m_counters.issued; break;
+    }
+    if(shadow && !update(*shadow, enabled)) return;
+    if(enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void ogl::StateCache::blendFunc(GLenum source, GLenum destination) noexcept
+{
+    if(m_blendFunc == std::array<unsigned, 2>{ source, destination }) {
+        ++m_counters.elided;
+        return;
+    }
+    m_blendFunc = { source, destination };
+    ++m_counters.issued;
+    glBlendFunc(source, destination);
+}
+
+void ogl::StateCache::viewport(int x, int y, int width, int height) noexcept
+{
+    if(m_viewport == std::array<int, 4>{ x, y, width, height }) {
+        ++m_counters.elided;
+        return;
+    }
+    m_viewport = { x, y, width, height };
+    ++m_counters.issued;
+    glViewport(x, y, width, height);
+}
+
+void ogl::StateCache::invalidate() noexcept
+{
+    m_program = m_vertexArray = m_framebuffer = UNKNOWN;
+    m_textures.fill(UNKNOWN);
+    m_capabilities.fill(UNKNOWN);
+    m_depthMask = m_depthFunc = m_cullFace = m_frontFace = UNKNOWN;
+    m_blendFunc.fill(UNKNOWN);
+    m_viewport.fill(-1); // negative sizes are invalid, never matches
+}
+
+// a deleted program stays in use until another one is bound, unknown is the safe answer for all of them
+void ogl::StateCache::forgetProgram(unsigned program) noexcept { if(m_program == program) m_program = UNKNOWN; }
+void ogl::StateCache::forgetVertexArray(unsigned vertexArray) noexcept { if(m_vertexArray == vertexArray) m_vertexArray = UNKNOWN; }
+void ogl::StateCache::forgetFramebuffer(unsigned framebuffer) noexcept { if(m_framebuffer == framebuffer) m_framebuffer = UNKNOWN; }
+void ogl::StateCache::forgetTexture(unsigned texture) noexcept { std::replace(m_textures.begin(), m_textures.end(), texture, UNKNOWN); }
+
+void ogl::StateCache::endFrame() noexcept
+{
+    if(m_counters.issued + m_counters.elided > 0) m_lastFrame = m_counters;
+    m_counters = {};
+}
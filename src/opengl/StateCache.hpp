@@ -0,0 +1,81 @@
+#pragma once
+#include "glad/gl.h"
+#include <array>
+
+namespace ogl
+{
+    /*
+    a shadow of the gl state the renderer touches, calls that would not change anything are skipped.
+    whatever changes this state behind its back has to call invalidate() afterwards, imgui restores what it touches.
+    deleted objects have to be forgotten, gl unbinds them and hands the name out again
+    */
+    class StateCache
+    {
+    public:
+        struct Counters {
+            unsigned issued = 0;
+            unsigned elided = 0;
+        };
+        static constexpr unsigned MAX_TEXTURE_UNITS = 32;   // higher units are not tracked, always issued
+    private:
+        static constexpr unsigned UNKNOWN = ~0u;
+        enum Capability { DEPTH_TEST, CULL_FACE, BLEND, FRAMEBUFFER_SRGB, NUM_CAPABILITIES };
+
+        unsigned m_program;
+        unsigned m_vertexArray;
+        unsigned m_framebuffer;
+        std::array<unsigned, MAX_TEXTURE_UNITS> m_textures;
+        std::array<unsigned, NUM_CAPABILITIES> m_capabilities;
+        unsigned m_depthMask;
+        unsigned m_depthFunc;
+        unsigned m_cullFace;
+        unsigned m_frontFace;
+        std::array<unsigned, 2> m_blendFunc;
+        std::array<int, 4> m_viewport;
+        Counters m_counters;
+        Counters m_lastFrame;
+
+        // true when the call has to be issued
+        inline bool update(unsigned &shadow, unsigned value) noexcept
+        {
+            if(shadow == value) {
+                ++m_counters.elided;
+                return false;
+            }
+            shadow = value;
+            ++m_counters.issued;
+            return true;
+        }
+    public:
+        StateCache() noexcept { invalidate(); }
+
+        inline void useProgram(unsigned program) noexcept { if(update(m_program, program)) glUseProgram(program); }
+        inline void bindVertexArray(unsigned vertexArray) noexcept { if(update(m_vertexArray, vertexArray)) glBindVertexArray(vertexArray); }
+        // draw and read
+        inline void bindFramebuffer(unsigned framebuffer) noexcept { if(update(m_framebuffer, framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer); }
+        // glBindTextureUnit, the target comes from the texture so there is no active unit to track
+        void bindTextureUnit(unsigned unit, unsigned texture) noexcept;
+        // GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND and GL_FRAMEBUFFER_SRGB are tracked, the rest is passed through
+        void setEnabled(GLenum capability, bool enabled) noexcept;
+        inline void depthMask(bool write) noexcept { if(update(m_depthMask, write)) glDepthMask(write); }
+        inline void depthFunc(GLenum func) noexcept { if(update(m_depthFunc, func)) glDepthFunc(func); }
+        inline void cullFace(GLenum face) noexcept { if(update(m_cullFace, face)) glCullFace(face); }
+        inline void frontFace(GLenum winding) noexcept { if(update(m_frontFace, winding)) glFrontFace(winding); }
+        void blendFunc(GLenum source, GLenum destination) noexcept;
+        void viewport(int x, int y, int width, int height) noexcept;
+
+        // everything unknown, the next call of each kind is issued
+        void invalidate() noexcept;
+        void forgetProgram(unsigned program) noexcept;
+        void forgetVertexArray(unsigned vertexArray) noexcept;
+        void forgetFramebuffer(unsigned framebuffer) noexcept;
+        void forgetTexture(unsigned texture) noexcept;
+
+        // once per frame. frames without any state calls keep the previous numbers, an idle editor draws nothing
+        void endFrame() noexcept;
+        inline Counters const &getLastFrame() const noexcept { return m_lastFrame; }
+    };
+
+    // the one of the current context, the editor only draws with one
+    StateCache &getStateCache() noexcept;
+} // namespace ogl
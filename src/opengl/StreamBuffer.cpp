@@ -0,0 +1,85 @@
+#include "StreamBuffer.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+
+ogl::StreamBuffer::StreamBuffer(size_t size, unsigned framesInFlight) :
+    m_size(size),
+    m_framesInFlight(std::max(framesInFlight, 1u))
+{
+    GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &m_renderID);
+    glNamedBufferStorage(m_renderID, size, nullptr, flags);
+    m_data = static_cast<char *>(glMapNamedBufferRange(m_renderID, 0, size, flags));
+    if(!m_data) throw std::runtime_error{"failed to map a stream buffer"};
+}
+ogl::StreamBuffer::~StreamBuffer()
+{
+    for(Fence const &fence : m_fences) glDeleteSync(fence.sync);
+    if(canDeallocate()) glUnmapNamedBuffer(m_renderID);
+}
+
+bool ogl::StreamBuffer::fits(size_t offset, size_t size) const noexcept
+{
+    if(offset + size > m_size) return false;
+    // in use from the oldest fenced frame up to the head, going forward and possibly wrapping
+    size_t begin = m_fences.empty() ? m_frameBegin : m_fences.front().begin;
+    bool empty = m_fences.empty() && m_frameBytes == 0;
+    if(empty) return true;
+    if(m_head > begin) return offset >= m_head || offset + size <= begin;
+    if(m_head < begin) return offset >= m_head && offset + size <= begin;
+    return false; // head caught up with the oldest frame, full
+}
+
+void ogl::StreamBuffer::waitOldest() noexcept
+{
+    GLsync sync = m_fences.front().sync;
+    m_fences.pop_front();
+    if(glClientWaitSync(sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        ++m_stats.numFenceWaits;
+        auto start = std::chrono::steady_clock::now();
+        // flush, the fence might still sit in the command queue
+        while(glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED);
+        m_stats.waitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    glDeleteSync(sync);
+}
+
+ogl::StreamBuffer::Allocation ogl::StreamBuffer::allocate(size_t size, size_t alignment) noexcept
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "alignment has to be a power of two");
+    size_t offset = (m_head + alignment - 1) & ~(alignment - 1);
+    // the tail of the buffer is skipped rather than splitting the allocation
+    if(offset + size > m_size) offset = 0;
+    while(!fits(offset, size)) {
+        if(m_fences.empty()) {
+            // this frame alone wants more than the ring holds
+            ++m_stats.numOverflows;
+            return {};
+        }
+        waitOldest();
+    }
+    // the frame starts at its first allocation, a wrapped one would otherwise be fenced from the old head
+    if(m_frameBytes == 0) m_frameBegin = offset;
+    m_head = offset + size;
+    m_frameBytes += size;
+    return { m_data + offset, offset };
+}
+
+void ogl::StreamBuffer::endFrame() noexcept
+{
+    if(m_frameBytes > 0) {
+        m_fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_frameBegin });
+        m_frameBegin = m_head;
+        m_stats.frameBytes = m_frameBytes;
+        m_stats.peakFrameBytes = std::max(m_stats.peakFrameBytes, m_frameBytes);
+        m_frameBytes = 0;
+    }
+    // whatever the gpu already finished is free without waiting
+    while(!m_fences.empty() && glClientWaitSync(m_fences.front().sync, 0, 0) != GL_TIMEOUT_EXPIRED) {
+        glDeleteSync(m_fences.front().sync);
+        m_fences.pop_front();
+    }
+    while(m_fences.size() >= m_framesInFlight) waitOldest();
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "VertexBuffer.hpp"
+#include "glad/gl.h"
+#include <cstddef>
+#include <deque>
+
+namespace ogl
+{
+    /*
+    a ring over one persistently mapped, coherent buffer for data written every frame.
+    allocations are written through the pointer and used at their offset, no glBufferSubData and no implicit sync.
+    endFrame() fences what the frame used, space is reclaimed once the gpu passed the fence. at most framesInFlight
+    frames are queued, the cpu waits on the oldest fence before running further ahead
+    */
+    class StreamBuffer : public VertexBuffer
+    {
+    public:
+        struct Allocation {
+            void *data = nullptr;   // nullptr when the frame asked for more than the whole ring
+            size_t offset = 0;
+        };
+        struct Stats {
+            unsigned numFenceWaits = 0;     // fences that were not signaled yet when the space was needed
+            double waitSeconds = 0;
+            unsigned numOverflows = 0;
+            size_t frameBytes = 0;          // allocated by the last finished frame
+            size_t peakFrameBytes = 0;
+        };
+    private:
+        struct Fence {
+            GLsync sync;
+            size_t begin;   // the frame used [begin, the next fence's begin)
+        };
+        size_t m_size = 0;
+        unsigned m_framesInFlight = 0;
+        char *m_data = nullptr;
+        size_t m_head = 0;          // next free byte
+        size_t m_frameBegin = 0;
+        size_t m_frameBytes = 0;
+        std::deque<Fence> m_fences;
+        Stats m_stats;
+
+        bool fits(size_t offset, size_t size) const noexcept;
+        void waitOldest() noexcept;
+    public:
+        StreamBuffer(size_t size, unsigned framesInFlight = 3);
+        ~StreamBuffer();
+        StreamBuffer(StreamBuffer const &) = delete;
+        StreamBuffer &operator=(StreamBuffer const &) = delete;
+
+        // alignment has to be a power of two, e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform ranges
+        Allocation allocate(size_t size, size_t alignment = 16) noexcept;
+        // after the draws that read this frame's allocations were issued
+        void endFrame() noexcept;
+
+        inline size_t getSize() const noexcept { return m_size; }
+        inline Stats const &getStats() const noexcept { return m_stats; }
+    };
+} // namespace ogl
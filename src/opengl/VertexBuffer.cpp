@@ -1,5 +1,6 @@
 #include <cassert>
 #include "VertexBuffer.hpp"
+#include "StateCache.hpp"
 
 ogl::VertexBuffer::VertexBuffer(size_t size, GLenum usage)
 {
@@ -32,11 +33,22 @@ size_t ogl::getSizeOfGLType(GLenum type)
         case GL_UNSIGNED_INT:    return sizeof(GLuint);
         case GL_FLOAT:           return sizeof(GLfloat);
         case GL_DOUBLE:          return sizeof(GLdouble);
+        case GL_HALF_FLOAT:      return sizeof(GLhalf);
+        case GL_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV: return sizeof(GLuint);
         default: 
             assert(false && "type not supported");
             return 0;
     }
 }
+size_t ogl::getSizeOfGLAttribute(unsigned count, GLenum type)
+{
+    if(type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV) {
+        assert(count == 4 && "packed types have four components");
+        return getSizeOfGLType(type);
+    }
+    return count * getSizeOfGLType(type);
+}
 
 void ogl::VertexArray::addBuffer(VertexBuffer const &buffer, InterleavedVertexBufferLayout const &layout)
 {
@@ -44,9 +56,9 @@ void ogl::VertexArray::addBuffer(VertexBuffer const &buffer, InterleavedVertexBu
     buffer.bind();
     unsigned offset = 0;
     for(InterleavedVertexBufferLayout::Element const &element : layout.getElements()) {
-        glVertexAttribPointer(m_vertexAttribIndex, element.count, element.type, false, layout.getStride(), reinterpret_cast<void const *>(offset));
+        glVertexAttribPointer(m_vertexAttribIndex, element.count, element.type, element.normalized, layout.getStride(), reinterpret_cast<void const *>(offset));
         glEnableVertexAttribArray(m_vertexAttribIndex);
-        offset += element.count * getSizeOfGLType(element.type);
+        offset += getSizeOfGLAttribute(element.count, element.type);
         ++m_vertexAttribIndex;
     }
 }
@@ -54,7 +66,8 @@ void ogl::VertexArray::addBuffer(VertexBuffer const &buffer, VertexBufferLayout
 {
     bind(); buffer.bind();
     for(VertexBufferLayout::Element const &element : layout.getElements()) {
-        glVertexAttribPointer(m_vertexAttribIndex, element.count, element.type, false, element.count * getSizeOfGLType(element.type), reinterpret_cast<void const *>(element.offset));
+        unsigned stride = element.stride ? element.stride : getSizeOfGLAttribute(element.count, element.type);
+        glVertexAttribPointer(m_vertexAttribIndex, element.count, element.type, element.normalized, stride, reinterpret_cast<void const *>(element.offset));
         glEnableVertexAttribArray(m_vertexAttribIndex);
         ++m_vertexAttribIndex;
     }
@@ -82,11 +95,14 @@ void ogl::VertexArray::addBuffer(VertexBuffer const &buffer, InstancingVertexBuf
     }
 }
 
-void ogl::VertexArray::bind(unsigned) const noexcept { glBindVertexArray(m_renderID); }
+void ogl::VertexArray::setIndexBuffer(IndexBuffer const &buffer) noexcept { glVertexArrayElementBuffer(m_renderID, buffer.getRenderID()); }
+
+void ogl::VertexArray::bind(unsigned) const noexcept { getStateCache().bindVertexArray(m_renderID); }
 
 ogl::VertexArray::~VertexArray()
 {
     if(canDeallocate()) {
+        getStateCache().forgetVertexArray(m_renderID);
         glDeleteVertexArrays(1, &m_renderID);
     }
 }
@@ -124,7 +140,7 @@ ogl::InstancingVertexBufferLayout::InstancingVertexBufferLayout(std::vector<Elem
 void ogl::InterleavedVertexBufferLayout::push(Element const &element)
 {
     m_elements.push_back(element);
-    m_stride += element.count * getSizeOfGLType(element.type);
+    m_stride += getSizeOfGLAttribute(element.count, element.type);
 }
 void ogl::VertexBufferLayout::push(Element const &element)
 {
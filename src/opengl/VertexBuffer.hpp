@@ -1,12 +1,15 @@
 #pragma once
 #include "Object.hpp"
+#include "IndexBuffer.hpp"
 #include "glad/gl.h"
 #include <cstddef>
 #include <vector>
 
 namespace ogl
 {
+    // packed types (GL_INT_2_10_10_10_REV, GL_UNSIGNED_INT_2_10_10_10_REV) are the size of all four components
     size_t getSizeOfGLType(GLenum type);
+    size_t getSizeOfGLAttribute(unsigned count, GLenum type);
     class VertexBuffer : public Object 
     {
     private:
@@ -24,6 +27,7 @@ namespace ogl
         struct Element {
             unsigned count;
             unsigned type;
+            bool normalized = false;    // integer types read as [0, 1] (unsigned) or [-1, 1] (signed) floats
         };
     
     private:
@@ -45,6 +49,8 @@ namespace ogl
             unsigned count;
             GLenum type;
             size_t offset;
+            bool normalized = false;
+            unsigned stride = 0;    // 0 when the elements are tightly packed
         };
     private:
         std::vector<Element> m_elements;
@@ -108,6 +114,8 @@ namespace ogl
         void addBuffer(VertexBuffer const &buffer, VertexBufferLayout const &layout);
         void addBuffer(VertexBuffer const &buffer, InterleavedInstancingVertexBufferLayout const &layout);
         void addBuffer(VertexBuffer const &buffer, InstancingVertexBufferLayout const &layout);
+        // the elements glDrawElements reads while this array is bound
+        void setIndexBuffer(IndexBuffer const &buffer) noexcept;
 
         void bind(unsigned slot = 0) const noexcept override;
     };
@@ -0,0 +1,113 @@
+#include "FramePacer.hpp"
+#include "GLFW/glfw3.h"
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+char const *pacing::vsyncToString(Vsync vsync) noexcept
+{
+    switch (vsync)
+    {
+    case Vsync::OFF:      return "off";
+    case Vsync::ON:       return "on";
+    case Vsync::ADAPTIVE: return "adaptive";
+    default:              return "unknown";
+    }
+}
+
+pacing::FramePacer::FramePacer() : m_frameEnd(Clock::now()), m_deadline(m_frameEnd)
+{
+    m_history.reserve(HISTORY_SIZE);
+}
+
+void pacing::FramePacer::setSettings(Settings const &settings)
+{
+    m_settings = settings;
+    if(m_appliedVsync == settings.vsync) return;
+    m_appliedVsync = settings.vsync;
+    int interval = 0;
+    if(settings.vsync == Vsync::ON) interval = 1;
+    if(settings.vsync == Vsync::ADAPTIVE) {
+        bool tearSupported = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+        interval = tearSupported ? -1 : 1;
+    }
+    glfwSwapInterval(interval);
+}
+
+double pacing::FramePacer::getSleepEstimate() const noexcept
+{
+    double variance = m_sleepCount > 1 ? m_sleepM2 / (m_sleepCount - 1) : 0;
+    return m_sleepMean + std::sqrt(variance);
+}
+
+void pacing::FramePacer::sleepUntil(Clock::time_point deadline)
+{
+    using namespace std::chrono;
+    while(duration<double>(deadline - Clock::now()).count() > getSleepEstimate()) {
+        Clock::time_point start = Clock::now();
+        std::this_thread::sleep_for(milliseconds{1});
+        double observed = duration<double>(Clock::now() - start).count();
+        // welford. restarts now and then so the estimate follows changes in the scheduler, e.g. timer resolution
+        if(m_sleepCount >= 1000) {
+            m_sleepCount = 0;
+            m_sleepM2 = 0;
+        }
+        ++m_sleepCount;
+        double delta = observed - m_sleepMean;
+        m_sleepMean += delta / m_sleepCount;
+        m_sleepM2 += delta * (observed - m_sleepMean);
+    }
+    while(Clock::now() < deadline) std::this_thread::yield();
+}
+
+float pacing::FramePacer::endFrame()
+{
+    if(m_settings.targetFps > 0) {
+        auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{1.0 / m_settings.targetFps});
+        m_deadline += period;
+        // more than a frame behind, don't race to catch up
+        if(m_deadline + period < Clock::now()) m_deadline = Clock::now();
+        else sleepUntil(m_deadline);
+    }
+
+    Clock::time_point now = Clock::now();
+    float elapsed = std::chrono::duration<float>(now - m_frameEnd).count();
+    m_frameEnd = now;
+    if(m_settings.targetFps <= 0 || m_idle) m_deadline = now;
+    if(m_idle) {
+        m_deltatime = m_activeDeltatime;
+    } else {
+        m_deltatime = m_activeDeltatime = elapsed;
+        if(m_history.size() < HISTORY_SIZE) m_history.push_back(m_deltatime);
+        else m_history[m_next] = m_deltatime;
+        m_next = (m_next + 1) % HISTORY_SIZE;
+    }
+    m_idle = false;
+    return m_deltatime;
+}
+
+std::vector<float> pacing::FramePacer::getHistory() const
+{
+    if(m_history.size() < HISTORY_SIZE) return m_history;
+    std::vector<float> history{m_history.begin() + m_next, m_history.end()};
+    history.insert(history.end(), m_history.begin(), m_history.begin() + m_next);
+    return history;
+}
+
+pacing::FrameStats pacing::FramePacer::getStats() const
+{
+    FrameStats stats;
+    if(m_history.empty()) return stats;
+    std::vector<float> sorted = m_history;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](float p) { return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))] * 1.0E3f; };
+    float sum = 0;
+    for(float frameTime : sorted) sum += frameTime;
+    stats.mean = sum / sorted.size() * 1.0E3f;
+    stats.p50 = percentile(0.50f);
+    stats.p90 = percentile(0.90f);
+    stats.p99 = percentile(0.99f);
+    stats.max = sorted.back() * 1.0E3f;
+    stats.count = sorted.size();
+    return stats;
+}
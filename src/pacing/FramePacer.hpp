@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include <optional>
+#include <cstddef>
+
+namespace pacing
+{
+    enum class Vsync {
+        OFF,
+        ON,
+        ADAPTIVE    // tears instead of waiting a whole interval when a frame is late, ON where the driver can't
+    };
+    char const *vsyncToString(Vsync vsync) noexcept;
+
+    struct Settings {
+        Vsync vsync = Vsync::ON;
+        float targetFps = 0;            // 0 for no limit
+        bool operator==(Settings const &other) const noexcept { return vsync == other.vsync && targetFps == other.targetFps; }
+    };
+
+    // milliseconds over the recorded frames
+    struct FrameStats {
+        float mean = 0;
+        float p50 = 0;
+        float p90 = 0;
+        float p99 = 0;
+        float max = 0;
+        size_t count = 0;
+    };
+
+    /*
+    owns the swap interval, limits the frame rate and measures whole frames, end of one to the end of the next.
+    the limiter sleeps while the remaining time is safely above what a sleep tends to overshoot by
+    (mean plus one deviation, learned from the sleeps themselves) and spins the rest.
+    */
+    class FramePacer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr size_t HISTORY_SIZE = 512;
+    private:
+        Settings m_settings;
+        std::optional<Vsync> m_appliedVsync;
+        Clock::time_point m_frameEnd;
+        Clock::time_point m_deadline;
+        float m_deltatime = 0;
+        float m_activeDeltatime = 1.0f / 60;    // of the last frame that did not wait for events
+        bool m_idle = false;
+
+        std::vector<float> m_history;   // seconds, ring buffer
+        size_t m_next = 0;
+
+        // sleep overshoot, running mean and variance of 1 ms sleeps
+        double m_sleepMean = 0.001;
+        double m_sleepM2 = 0;
+        unsigned m_sleepCount = 0;
+
+        void sleepUntil(Clock::time_point deadline);
+    public:
+        FramePacer();
+
+        // applies the swap interval when it changed, needs the gl context current
+        void setSettings(Settings const &settings);
+        // call right after swapping buffers. waits for the target frame rate, returns the frame time in seconds
+        float endFrame();
+        // the current frame waited for events, its time says nothing about rendering and stays out of the stats.
+        // endFrame() returns the last active frame's time for it, so motion scaled by it does not jump after a wait
+        inline void markIdle() noexcept { m_idle = true; }
+
+        inline Settings const &getSettings() const noexcept { return m_settings; }
+        inline float getDeltatime() const noexcept { return m_deltatime; }
+        // what the limiter expects a sleep to overshoot by, seconds
+        double getSleepEstimate() const noexcept;
+        // oldest first, seconds
+        std::vector<float> getHistory() const;
+        FrameStats getStats() const;
+    };
+} // namespace pacing
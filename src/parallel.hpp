@@ -0,0 +1,58 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+namespace parallel
+{
+    namespace detail
+    {
+        inline std::atomic_uint numWorkersOverride = 0;
+    } // namespace detail
+
+    // 0 goes back to one worker per hardware thread
+    inline void setNumWorkers(unsigned count) { detail::numWorkersOverride = count; }
+    inline unsigned getNumWorkers()
+    {
+        unsigned count = detail::numWorkersOverride;
+        return count ? count : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // calls func(i) for every i in [0, count) from all workers in chunks, blocks until done.
+    // the first exception thrown by func is rethrown on the calling thread
+    template <typename Func_t>
+    inline void forEach(size_t count, Func_t const &func, size_t chunkSize = 1)
+    {
+        chunkSize = std::max<size_t>(chunkSize, 1);
+        size_t numChunks = (count + chunkSize - 1) / chunkSize;
+        unsigned numWorkers = static_cast<unsigned>(std::min<size_t>(getNumWorkers(), numChunks));
+        std::atomic_size_t nextChunk = 0;
+        std::exception_ptr error = nullptr;
+        std::atomic_flag errorLock = ATOMIC_FLAG_INIT;
+
+        auto work = [&]() {
+            for(size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+                try {
+                    for(size_t i = chunk * chunkSize; i < std::min(count, (chunk + 1) * chunkSize); ++i) {
+                        func(i);
+                    }
+                } catch(...) {
+                    if(!errorLock.test_and_set()) error = std::current_exception();
+                    nextChunk = numChunks;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(unsigned i = 1; i < numWorkers; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for(std::thread &worker : workers) {
+            worker.join();
+        }
+        if(error) std::rethrow_exception(error);
+    }
+} // namespace parallel